@@ -131,6 +131,13 @@ def _STACK_ALIGNMENT_check_value(stack_alignment:MemSize, config: dict):
         return True, None
 
 
+def _MAX_CPUS_check_value(max_cpus:int, config: dict):
+    if max_cpus < 1:
+        return False, 'MAX_CPUS must be at least 1.'
+    else:
+        return True, None
+
+
 CONFIGS = {
     'ARCH': {
         'description': 'The target architecture the kernel will compile to.',
@@ -180,6 +187,12 @@ CONFIGS = {
         'default_value': _STACK_ALIGNMENT_default_value,
         'value_checker': _STACK_ALIGNMENT_check_value,
     },
+    'MAX_CPUS': {
+        'description': 'Maximum number of CPUs the kernel keeps per-CPU data for.',
+        'type': int,
+        'default_value': 64,
+        'value_checker': _MAX_CPUS_check_value,
+    },
     'MULTIBOOT2': {
         'description': 'Enabling this makes kernel multiboot2 specification comliant.',
         'type': bool,
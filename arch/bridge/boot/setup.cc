@@ -1,13 +1,47 @@
 #include <arch/boot/setup.h>
+#include <arch/memory.h>
+#include <x86/boot/setup.h>
+#include <x86/cpuid.h>
+#include <x86/interrupts/idt.h>
+#include <x86/interrupts/pic.h>
+#include <x86/paging/tlb.h>
+#include <x86/system.h>
+#include <klibc/cpu_features.h>
 
 
 namespace arch {
 
 static BootInfo *boot_info;
 
+static void setup_klibc(const x86::ArchInfo& arch_info)
+{
+	unsigned int features = 0;
+	if (kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::SSE2))
+		features |= klibc::CPU_SSE2;
+	if (kstd::test_flag(arch_info.feature_flags,
+			x86::FeatureFlags::XSAVE | x86::FeatureFlags::AVX | x86::FeatureFlags::AVX2)) {
+		x86::enable_avx();
+		features |= klibc::CPU_AVX2;
+	}
+	if (kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::ERMS))
+		features |= klibc::CPU_ERMS;
+	if (kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::FSRM))
+		features |= klibc::CPU_FSRM;
+	klibc::set_cpu_features(features);
+}
+
 void setup(BootInfo *boot_info)
 {
-	arch::boot_info = boot_info;
+	// the entry code passes the physical address of the boot info
+	arch::boot_info = phys_to_virt(reinterpret_cast<uintptr_t>(boot_info));
+
+	x86::ArchInfo arch_info;
+	x86::cpuid__assume_cpuid_present(arch_info);
+	x86::setup_tlb(arch_info);
+	setup_klibc(arch_info);
+	// after AVX is enabled, so the interrupt entry knows to save it
+	x86::disable_legacy_pic();
+	x86::setup_interrupts();
 }
 
 BootInfo *get_boot_info()
@@ -15,4 +49,23 @@ BootInfo *get_boot_info()
 	return boot_info;
 }
 
+PhysicalMMap get_physical_mmap()
+{
+	const auto& x86_boot_info = *static_cast<x86::BootInfo *>(boot_info);
+	return {
+		.entries = static_cast<PhysicalMMap::Entry *>(
+				phys_to_virt(x86_boot_info.mmap.entries.addr)),
+		.nr_entries = static_cast<size_t>(x86_boot_info.mmap.nr_entries),
+	};
+}
+
+PhysicalMMap get_free_physical_mmap()
+{
+	auto& early_arena = static_cast<x86::BootInfo *>(boot_info)->early_arena;
+	return {
+		.entries = const_cast<PhysicalMMap::Entry *>(early_arena.get_regions()),
+		.nr_entries = early_arena.get_nr_regions(),
+	};
+}
+
 }
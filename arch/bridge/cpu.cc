@@ -0,0 +1,54 @@
+#include <arch/cpu.h>
+#include <x86/system.h>
+#include <x86/time/tsc.h>
+
+
+namespace arch {
+
+void cpu_relax()
+{
+	asm volatile ("pause");
+}
+
+void wait_for_interrupt()
+{
+	asm volatile ("hlt");
+}
+
+uint64_t read_cycle_counter()
+{
+	return x86::read_tsc();
+}
+
+uint64_t get_cycle_counter_frequency()
+{
+	return x86::get_tsc_frequency();
+}
+
+bool is_cycle_counter_invariant()
+{
+	return x86::is_tsc_invariant();
+}
+
+unsigned int get_cpu_id()
+{
+	// only the bootstrap processor runs for now
+	return 0;
+}
+
+void irq_enable()
+{
+	x86::irq_enable();
+}
+
+IrqState irq_save()
+{
+	return x86::irq_save();
+}
+
+void irq_restore(IrqState state)
+{
+	x86::irq_restore(state);
+}
+
+}
@@ -0,0 +1,64 @@
+#include <arch/interrupts.h>
+#include <arch/cpu.h>
+#include <arch/paging.h>
+#include <x86/cpuid.h>
+#include <x86/interrupts/apic.h>
+#include <x86/interrupts/idt.h>
+
+#include <kstd/algorithm.h>
+
+
+namespace arch {
+
+bool setup_interrupt_controller()
+{
+	x86::ArchInfo arch_info;
+	x86::cpuid__assume_cpuid_present(arch_info);
+	if (!kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::APIC))
+		return false;
+
+	// registers are MSRs in the x2APIC mode, nothing to map
+	if (kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::x2APIC)) {
+		x86::setup_apic(nullptr);
+		return true;
+	}
+
+	auto *regs = static_cast<volatile uint32_t *>(
+			map_mmio(x86::get_apic_phys_addr(), page_size));
+	if (!regs)
+		return false;
+	x86::setup_apic(regs);
+	return true;
+}
+
+void set_panic_handler(PanicHandler handler)
+{
+	x86::set_panic_hook(handler);
+}
+
+InterruptCost measure_interrupt_cost(unsigned int nr_rounds)
+{
+	uint64_t overhead = UINT64_MAX;
+	uint64_t min_cycles = UINT64_MAX;
+	uint64_t tot_cycles = 0;
+
+	for (unsigned int i = 0; i < nr_rounds; ++i) {
+		const uint64_t start = read_cycle_counter();
+		overhead = kstd::min(overhead, read_cycle_counter() - start);
+	}
+
+	for (unsigned int i = 0; i < nr_rounds; ++i) {
+		const uint64_t start = read_cycle_counter();
+		x86::raise_benchmark_interrupt();
+		const uint64_t cycles = read_cycle_counter() - start - overhead;
+		min_cycles = kstd::min(min_cycles, cycles);
+		tot_cycles += cycles;
+	}
+
+	return {
+		.min_cycles = nr_rounds ? min_cycles : 0,
+		.avg_cycles = nr_rounds ? tot_cycles / nr_rounds : 0,
+	};
+}
+
+}
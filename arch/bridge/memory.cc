@@ -0,0 +1,9 @@
+#include <arch/memory.h>
+#include <x86/addressing.h>
+
+
+namespace arch {
+
+const uintptr_t direct_map_offset = x86::direct_map_offset;
+
+}
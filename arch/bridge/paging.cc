@@ -0,0 +1,52 @@
+#include <arch/paging.h>
+#include <arch/cpu.h>
+#include <x86/paging.h>
+#include <x86/paging/page_table_pool.h>
+
+#include <kstd/memory.h>
+
+
+namespace arch {
+
+static x86::PageTablePool page_table_pool;
+
+void setup_paging(AllocFrame alloc_frame, FreeFrame free_frame)
+{
+	page_table_pool.init(alloc_frame, free_frame);
+}
+
+bool prepare_page_table()
+{
+	const IrqState irq_state = irq_save();
+	const bool prepared = page_table_pool.refill_one();
+	irq_restore(irq_state);
+	return prepared;
+}
+
+volatile void *map_mmio(PhysAddr addr, size_t size)
+{
+	using x86::PageEntryFlags;
+
+	// the registers go where they would be in the direct map, which
+	// only maps RAM
+	x86::PageMappingInfo map_info;
+	map_info.phyaddr_beg = kstd::align_floored(addr, page_size_shift);
+	map_info.phyaddr_end = kstd::align_ceiled(addr + size, page_size_shift);
+	map_info.linaddr_beg = x86::page_fit_linear_addr(x86::direct_map_offset + map_info.phyaddr_beg);
+	map_info.flags = PageEntryFlags::Global | PageEntryFlags::Supervisor
+		| PageEntryFlags::WriteAllowed | PageEntryFlags::ExecuteDisabled
+		| PageEntryFlags::CacheDisabled;
+	map_info.max_page_size = x86::PageSize::_4Kb;
+
+	auto *page_table = static_cast<x86::PageTable *>(
+			page_table_pool.to_virt(x86::read_cr3() & x86::constants::pte_pt_mask));
+
+	const IrqState irq_state = irq_save();
+	const x86::PageMapErr e = page_table->map_memory(map_info, page_table_pool);
+	irq_restore(irq_state);
+	if (e != x86::PageMapErr::None)
+		return nullptr;
+	return static_cast<volatile void *>(phys_to_virt(addr));
+}
+
+}
@@ -0,0 +1,41 @@
+#include <arch/timer.h>
+#include <x86/cpuid.h>
+#include <x86/interrupts/apic.h>
+#include <x86/time/apic_timer.h>
+
+
+namespace arch {
+
+static TimerHandler timer_handler;
+
+static void handle_timer_interrupt(unsigned int)
+{
+	x86::apic_eoi();
+	timer_handler();
+}
+
+bool setup_timer(TimerHandler handler)
+{
+	x86::ArchInfo arch_info;
+	x86::cpuid__assume_cpuid_present(arch_info);
+	if (!kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::APIC))
+		return false;
+
+	timer_handler = handler;
+	x86::setup_apic_timer(
+		kstd::test_flag(arch_info.feature_flags, x86::FeatureFlags::TSC_Deadline),
+		handle_timer_interrupt);
+	return true;
+}
+
+void set_timer_deadline(uint64_t deadline)
+{
+	x86::set_apic_timer_deadline(deadline);
+}
+
+void stop_timer()
+{
+	x86::stop_apic_timer();
+}
+
+}
@@ -11,9 +11,11 @@ enum class PhysicalMMapType {
 };
 
 struct PhysicalMMap {
-	struct Entry {
-		uintptr_t base_addr;
-		size_t length;
+	/* Entries are filled by the 32bit entry code and read by the kernel,
+	 * so they have fixed width fields and alignment. */
+	struct alignas(8) Entry {
+		uint64_t base_addr;
+		uint64_t length;
 		PhysicalMMapType type;
 	} *entries;
 	size_t nr_entries;
@@ -28,6 +30,14 @@ void setup(BootInfo *boot_info);
 
 BootInfo *get_boot_info();
 
+/* Get the physical memory map reported by the bootloader. */
+PhysicalMMap get_physical_mmap();
+
+/* Get the RAM left free after boot, sorted by address. It excludes the kernel
+ * image, the boot info, the early page tables and the memory below the kernel
+ * image which is left to the firmware. */
+PhysicalMMap get_free_physical_mmap();
+
 }
 
 #endif
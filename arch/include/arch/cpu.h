@@ -0,0 +1,44 @@
+#ifndef _ARCH__CPU_H__
+#define _ARCH__CPU_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace arch {
+
+/* Size of a cache line, the unit of sharing between CPUs. */
+constexpr size_t cache_line_size = 64;
+
+/* Saved interrupt state of a CPU. */
+using IrqState = unsigned long;
+
+/* Hint the CPU that it's in a busy-wait loop. */
+void cpu_relax();
+
+/* Stop the CPU until the next interrupt. */
+void wait_for_interrupt();
+
+/* Read the free-running cycle counter of the CPU. */
+uint64_t read_cycle_counter();
+
+/* Frequency of the cycle counter in Hz, 0 if it can't be found out. It may
+ * have to be measured, which takes a while. */
+uint64_t get_cycle_counter_frequency();
+
+/* Whether the cycle counter keeps its rate in all power states, only then
+ * it's usable as a clock. */
+bool is_cycle_counter_invariant();
+
+/* Get the id of the current CPU. */
+unsigned int get_cpu_id();
+
+/* Enable interrupts on the current CPU. */
+void irq_enable();
+/* Disable interrupts on the current CPU and return the previous state. */
+IrqState irq_save();
+/* Restore the interrupt state returned by irq_save. */
+void irq_restore(IrqState state);
+
+}
+
+#endif
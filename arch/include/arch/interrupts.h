@@ -0,0 +1,30 @@
+#ifndef _ARCH__INTERRUPTS_H__
+#define _ARCH__INTERRUPTS_H__
+
+#include <stdint.h>
+
+namespace arch {
+
+/* Setup the interrupt controller of the CPU. Its registers may have to be
+ * mapped, so it needs setup_paging() first. Returns false if there's none. */
+bool setup_interrupt_controller();
+
+/* Called once on a fatal exception, with interrupts disabled, before the
+ * arch code reports it on its console. */
+using PanicHandler = void (*)();
+
+void set_panic_handler(PanicHandler handler);
+
+/* Cycles it takes to enter and leave an interrupt handler. */
+struct InterruptCost {
+	uint64_t min_cycles;
+	uint64_t avg_cycles;
+};
+
+/* Measure the cost of nr_rounds interrupts raised by software to a handler
+ * doing nothing, without the cost of reading the cycle counter. */
+InterruptCost measure_interrupt_cost(unsigned int nr_rounds);
+
+}
+
+#endif
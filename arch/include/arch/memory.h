@@ -0,0 +1,37 @@
+#ifndef _ARCH__MEMORY_H__
+#define _ARCH__MEMORY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <config.h>
+
+namespace arch {
+
+using PhysAddr = uint64_t;
+using PhysSize = uint64_t;
+
+/* Smallest page size and its shift. */
+constexpr unsigned int page_size_shift = 12;
+constexpr size_t page_size = CONFIG_PAGE_SIZE;
+
+static_assert(page_size == size_t(1) << page_size_shift);
+
+/* Offset of the linear memory region that maps all of the physical RAM. */
+extern const uintptr_t direct_map_offset;
+
+/* Get the pointer through which the given physical address can be accessed. */
+inline void *phys_to_virt(PhysAddr addr)
+{
+	return reinterpret_cast<void *>(static_cast<uintptr_t>(addr) + direct_map_offset);
+}
+
+/* Get the physical address of a pointer obtained with phys_to_virt. */
+inline PhysAddr virt_to_phys(const void *ptr)
+{
+	return static_cast<PhysAddr>(reinterpret_cast<uintptr_t>(ptr) - direct_map_offset);
+}
+
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _ARCH__PAGING_H__
+#define _ARCH__PAGING_H__
+
+#include <arch/memory.h>
+
+namespace arch {
+
+/* Functions single frames are allocated and freed with. */
+using AllocFrame = PhysAddr (*)();
+using FreeFrame = void (*)(PhysAddr frame);
+
+/* Setup the memory the page tables are made of from now on. */
+void setup_paging(AllocFrame alloc_frame, FreeFrame free_frame);
+
+/* Prepare a page table ahead of time, so mapping memory later is faster.
+ * Returns false if there's nothing left to prepare. */
+bool prepare_page_table();
+
+/* Map the device registers at the physical memory [addr, addr + size) with
+ * the caches bypassed. Returns where they are mapped, nullptr on failure. */
+volatile void *map_mmio(PhysAddr addr, size_t size);
+
+}
+
+#endif
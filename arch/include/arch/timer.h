@@ -0,0 +1,25 @@
+#ifndef _ARCH__TIMER_H__
+#define _ARCH__TIMER_H__
+
+#include <stdint.h>
+
+namespace arch {
+
+/* Called from the timer interrupt, with interrupts disabled. */
+using TimerHandler = void (*)();
+
+/* Setup the one-shot timer of the CPU. It raises no interrupts until a
+ * deadline is set. Needs setup_interrupt_controller() first. Returns false
+ * if the CPU has no timer to use. */
+bool setup_timer(TimerHandler handler);
+
+/* Call the handler once the cycle counter reaches deadline, replacing the
+ * deadline set before. Deadlines far ahead may fire early. */
+void set_timer_deadline(uint64_t deadline);
+
+/* Cancel the deadline set. */
+void stop_timer();
+
+}
+
+#endif
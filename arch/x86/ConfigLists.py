@@ -1,3 +1,6 @@
+from scripts.config.utils import MemLoc, MemSize
+
+
 def _x86_PAGE_MAP_LEVEL_default_value(config:dict):
     arch = config['ARCH']
     if arch == 'x86_64':
@@ -23,6 +26,33 @@ def _x86_PHYS_ADDR_64_BIT_value_checker(value:bool, config:dict):
     return True, None
 
 
+def _x86_DIRECT_MAP_OFFSET_default_value(config:dict):
+    if config['ARCH'] == 'x86_64':
+        return MemLoc(0xFFFF800000000000)
+    else:
+        return None
+
+
+def _x86_DIRECT_MAP_OFFSET_check_value(value:MemLoc, config:dict):
+    """
+    Check that the direct map offset is a canonical, page aligned address.
+    """
+    if config['ARCH'] != 'x86_64':
+        passed = value is None
+        return passed, None if passed else 'x86_DIRECT_MAP_OFFSET is only used on x86_64.'
+
+    offset = value.bytes() if isinstance(value, MemSize) else value
+    if offset % config['PAGE_SIZE'].bytes() != 0:
+        return False, 'x86_DIRECT_MAP_OFFSET must be divisible by PAGE_SIZE.'
+
+    # bits from the highest linear address bit on must all be equal
+    addr_bits = 57 if config['x86_PAGE_MAP_LEVEL'] == 'PAGE_MAP_LEVEL_5' else 48
+    upper_bits = offset >> (addr_bits - 1)
+    if offset >= 1 << 64 or upper_bits not in (0, (1 << (65 - addr_bits)) - 1):
+        return False, f'x86_DIRECT_MAP_OFFSET must be a canonical {addr_bits}-bit address.'
+    return True, None
+
+
 CONFIGS = {
     'x86_PAGE_MAP_LEVEL': {
         'description': 'Defines page map level in x86.',
@@ -44,4 +74,20 @@ CONFIGS = {
         'depends': ['ARCH'],
         'value_checker': _x86_PHYS_ADDR_64_BIT_value_checker,
     },
+    'x86_DIRECT_MAP_OFFSET': {
+        'description': 'Linear address all of the physical memory is mapped from.',
+        'type': MemLoc,
+        'depends': ['ARCH', 'PAGE_SIZE', 'x86_PAGE_MAP_LEVEL'],
+        'default_value': _x86_DIRECT_MAP_OFFSET_default_value,
+        'value_checker': _x86_DIRECT_MAP_OFFSET_check_value,
+    },
+    'x86_KERNEL_OSTREAM': {
+        'description': 'Device the kernel output stream writes to.',
+        'type': str,
+        'value_set': {
+            'VGA',
+            'SERIAL'
+        },
+        'default_value': 'VGA',
+    },
 }
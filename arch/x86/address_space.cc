@@ -0,0 +1,80 @@
+#include <x86/paging/address_space.h>
+#include <x86/cr.h>
+
+
+namespace x86 {
+
+/* Set in CR3 to keep the TLB entries of the loaded PCID. */
+static constexpr unsigned long cr3_no_flush = 1ul << 63;
+
+static uint64_t next_ctx_id = 1;
+
+AddressSpace::AddressSpace(PhysAddr pt_addr)
+	: pt_addr(pt_addr), ctx_id(__atomic_fetch_add(&next_ctx_id, 1, __ATOMIC_RELAXED))
+{
+}
+
+void TLBContext::switch_to(AddressSpace& as)
+{
+	if (curr_as == &as)
+		return;
+	curr_as = &as;
+
+	if (!is_pcid_enabled()) {
+		write_cr3(as.pt_addr);
+		return;
+	}
+
+	++clock;
+	unsigned long pcid = find_pcid(as);
+	if (pcid) {
+		slots[pcid - 1].last_used = clock;
+		write_cr3(as.pt_addr | pcid | cr3_no_flush);
+		return;
+	}
+
+	// reassign the least recently used PCID, loading CR3 without the
+	// no-flush bit drops whatever it tagged before
+	unsigned int victim = 0;
+	for (unsigned int i = 1; i < nr_pcids; ++i) {
+		if (slots[i].last_used < slots[victim].last_used)
+			victim = i;
+	}
+	slots[victim] = {
+		.ctx_id = as.ctx_id,
+		.last_used = clock,
+	};
+	write_cr3(as.pt_addr | (victim + 1));
+}
+
+void TLBContext::flush(AddressSpace& as, TLBFlushBatch& tlb_batch)
+{
+	if (curr_as == &as) {
+		tlb_batch.flush();
+		return;
+	}
+
+	const unsigned long pcid = find_pcid(as);
+	if (pcid && !is_invpcid_enabled()) {
+		// take the PCID away, so the next switch to the address space
+		// flushes its entries
+		slots[pcid - 1] = {};
+		tlb_batch.flush_other(0);
+		return;
+	}
+	tlb_batch.flush_other(pcid);
+}
+
+unsigned long TLBContext::find_pcid(const AddressSpace& as) const
+{
+	if (!is_pcid_enabled())
+		return 0;
+
+	for (unsigned int i = 0; i < nr_pcids; ++i) {
+		if (slots[i].ctx_id == as.ctx_id)
+			return i + 1;
+	}
+	return 0;
+}
+
+}
@@ -0,0 +1,143 @@
+#include <x86/boot/early_arena.h>
+
+#include <kstd/algorithm.h>
+#include <kstd/memory.h>
+
+
+namespace x86 {
+
+/* Only the memory addressable before enabling paging can be allocated. */
+static constexpr PhysAddr max_addr = UINTPTR_MAX;
+
+void EarlyArena::init(const Region *entries, size_t nr_entries)
+{
+	nr_regions = 0;
+	curr_region = 0;
+
+	// insertion sort the RAM entries by their base address
+	for (size_t i = 0; i < nr_entries; ++i) {
+		const Region& entry = entries[i];
+		if (entry.type != arch::PhysicalMMapType::RAM || entry.length == 0)
+			continue;
+		if (nr_regions == max_nr_regions)
+			break;
+
+		uint64_t j = nr_regions++;
+		for (; j > 0 && regions[j - 1].base_addr > entry.base_addr; --j)
+			regions[j] = regions[j - 1];
+		regions[j] = entry;
+	}
+
+	// merge the overlapping and adjacent regions
+	uint64_t nr_merged = 0;
+	for (uint64_t i = 0; i < nr_regions; ++i) {
+		if (nr_merged > 0) {
+			Region& last = regions[nr_merged - 1];
+			const PhysAddr last_end = last.base_addr + last.length;
+			if (regions[i].base_addr <= last_end) {
+				const PhysAddr end = regions[i].base_addr + regions[i].length;
+				last.length = kstd::max(last_end, end) - last.base_addr;
+				continue;
+			}
+		}
+		regions[nr_merged++] = regions[i];
+	}
+	nr_regions = nr_merged;
+}
+
+bool EarlyArena::reserve(PhysAddr beg, PhysAddr end)
+{
+	for (uint64_t i = 0; i < nr_regions;) {
+		Region& region = regions[i];
+		const PhysAddr region_beg = region.base_addr;
+		const PhysAddr region_end = region.base_addr + region.length;
+		if (end <= region_beg || region_end <= beg) {
+			++i;
+			continue;
+		}
+
+		if (beg <= region_beg && region_end <= end) {
+			remove_region(i);
+			continue;
+		}
+
+		if (region_beg < beg && end < region_end) {
+			// the reserved memory splits the region in two
+			if (nr_regions == max_nr_regions)
+				return false;
+			region.length = beg - region_beg;
+			insert_region(i + 1, {
+				.base_addr = end,
+				.length = region_end - end,
+				.type = arch::PhysicalMMapType::RAM,
+			});
+			return true;
+		}
+
+		if (region_beg < beg) {
+			region.length = beg - region_beg;
+		} else {
+			region.base_addr = end;
+			region.length = region_end - end;
+		}
+		++i;
+	}
+	return true;
+}
+
+PhysAddr EarlyArena::alloc(size_t size, unsigned int align_shift)
+{
+	kstd::MemoryRange range = acquire_range(size, align_shift);
+	if (range.beg >= range.end)
+		return 0;
+	range.beg += size;
+	release_range(range);
+	return reinterpret_cast<uintptr_t>(range.beg) - size;
+}
+
+kstd::MemoryRange EarlyArena::acquire_range(size_t min_size, unsigned int align_shift)
+{
+	for (; curr_region < nr_regions; ++curr_region) {
+		const Region& region = regions[curr_region];
+		if (region.base_addr >= max_addr)
+			break;
+
+		const PhysAddr beg = kstd::align_ceiled(region.base_addr, align_shift);
+		const PhysAddr end = kstd::min(region.base_addr + region.length, max_addr);
+		if (beg < region.base_addr || beg >= end || end - beg < min_size)
+			continue;
+		return kstd::MemoryRange(
+			reinterpret_cast<kstd::Byte *>(static_cast<uintptr_t>(beg)),
+			reinterpret_cast<kstd::Byte *>(static_cast<uintptr_t>(end)));
+	}
+	return {};
+}
+
+void EarlyArena::release_range(const kstd::MemoryRange& rest)
+{
+	Region& region = regions[curr_region];
+	const PhysAddr region_end = region.base_addr + region.length;
+	region.base_addr = reinterpret_cast<uintptr_t>(rest.beg);
+	region.length = region_end - region.base_addr;
+}
+
+void EarlyArena::insert_region(uint64_t idx, const Region& region)
+{
+	for (uint64_t i = nr_regions; i > idx; --i)
+		regions[i] = regions[i - 1];
+	regions[idx] = region;
+	++nr_regions;
+	if (curr_region > idx)
+		++curr_region;
+}
+
+void EarlyArena::remove_region(uint64_t idx)
+{
+	for (uint64_t i = idx + 1; i < nr_regions; ++i)
+		regions[i - 1] = regions[i];
+	--nr_regions;
+	if (curr_region > idx)
+		--curr_region;
+}
+
+}
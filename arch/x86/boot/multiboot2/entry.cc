@@ -27,7 +27,6 @@ extern "C" int _mb2_start(void *mb_info_tags_struct)
 
 	const size_t boot_cmd_size = strlen(mb_info.boot_cmd_line) + 1;
 
-	// +1 is for reserving memory used by BootInfo itself
 	const size_t mmap_entries_mem_size
 		= mb_info.mmap.nr_entries * sizeof(arch::PhysicalMMap::Entry);
 
@@ -51,22 +50,21 @@ extern "C" int _mb2_start(void *mb_info_tags_struct)
 	// assign total boot info memory size
 	boot_info->size = boot_info_mem_size;
 
-	// copy boot command
-	char *boot_cmd = reinterpret_cast<char *>(boot_info + 1);
-	boot_info->boot_cmd = boot_cmd;
-	strcpy(boot_cmd, mb_info.boot_cmd_line);
-
-	// copy mmap entries
-	auto *entries = reinterpret_cast<arch::PhysicalMMap::Entry *>(
-			boot_cmd + boot_cmd_size + 1);
-	boot_info->mmap.nr_entries = static_cast<size_t>(mb_info.mmap.nr_entries);
+	// copy mmap entries, they go first to keep them aligned
+	auto *entries = reinterpret_cast<arch::PhysicalMMap::Entry *>(boot_info + 1);
+	boot_info->mmap.nr_entries = mb_info.mmap.nr_entries;
 	boot_info->mmap.entries = entries;
-	for (uint32_t i = 0; i < boot_info->mmap.nr_entries; ++i) {
-		entries[i].base_addr = (uintptr_t)mb_info.mmap.entries[i].base_addr;
-		entries[i].length = (size_t)mb_info.mmap.entries[i].length;
+	for (uint32_t i = 0; i < mb_info.mmap.nr_entries; ++i) {
+		entries[i].base_addr = mb_info.mmap.entries[i].base_addr;
+		entries[i].length = mb_info.mmap.entries[i].length;
 		entries[i].type = mb2_to_boot_info_mmap_type(mb_info.mmap.entries[i].type);
 	}
 
+	// copy boot command
+	char *boot_cmd = reinterpret_cast<char *>(entries + mb_info.mmap.nr_entries);
+	boot_info->boot_cmd = boot_cmd;
+	strcpy(boot_cmd, mb_info.boot_cmd_line);
+
 	// call "bootloader-independent" entry passing boot_info
 	_i386_start(boot_info);
 
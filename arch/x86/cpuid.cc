@@ -15,7 +15,8 @@ static void cpuid__extended(struct ArchInfo& info);
 
 bool check_cpuid_presence()
 {
-	uint32_t curr_flags, prev_flags;
+	// pushf and pop work with the native register size
+	unsigned long curr_flags, prev_flags;
 	asm ( 	".equ ID_BIT, 1 << 21 	\n"
 		"pushf 			\n"
 		"pop %0 		\n"
@@ -45,6 +46,22 @@ bool cpuid(ArchInfo& info)
 	return true;
 }
 
+CPUID_Leaf read_cpuid_leaf(uint32_t leaf, uint32_t subleaf)
+{
+	uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+	const uint32_t requested_leaf = leaf;
+
+	// the highest standard or extended leaf
+	leaf &= 0x80000000;
+	CPUID();
+	if (requested_leaf > eax)
+		return {};
+
+	leaf = requested_leaf;
+	CPUID();
+	return {eax, ebx, ecx, edx};
+}
+
 static void cpuid__standard(ArchInfo& info)
 {
 	uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
@@ -66,16 +83,27 @@ static void cpuid__standard(ArchInfo& info)
 	info.feature_flags = info.feature_flags
 		| kstd::switch_flag(FeatureFlags::PSE, edx & (1 << 3))
 		| kstd::switch_flag(FeatureFlags::PAE, edx & (1 << 6))
-		| kstd::switch_flag(FeatureFlags::PGE, edx & (1 << 13));
+		| kstd::switch_flag(FeatureFlags::APIC, edx & (1 << 9))
+		| kstd::switch_flag(FeatureFlags::PGE, edx & (1 << 13))
+		| kstd::switch_flag(FeatureFlags::SSE2, edx & (1 << 26))
+		| kstd::switch_flag(FeatureFlags::PCID, ecx & (1 << 17))
+		| kstd::switch_flag(FeatureFlags::x2APIC, ecx & (1 << 21))
+		| kstd::switch_flag(FeatureFlags::TSC_Deadline, ecx & (1 << 24))
+		| kstd::switch_flag(FeatureFlags::XSAVE, ecx & (1 << 26))
+		| kstd::switch_flag(FeatureFlags::AVX, ecx & (1 << 28));
 
 	leaf = 0x07;
 	if (leaf > max_standard_leaf)
 		return;
 	CPUID();
 	info.feature_flags = info.feature_flags
+		| kstd::switch_flag(FeatureFlags::AVX2, ebx & (1 << 5))
 		| kstd::switch_flag(FeatureFlags::SMEP, ebx & (1 << 7))
+		| kstd::switch_flag(FeatureFlags::ERMS, ebx & (1 << 9))
+		| kstd::switch_flag(FeatureFlags::INVPCID, ebx & (1 << 10))
 		| kstd::switch_flag(FeatureFlags::SMAP, ebx & (1 << 20))
-		| kstd::switch_flag(FeatureFlags::LA57, ecx & (1 << 16));
+		| kstd::switch_flag(FeatureFlags::LA57, ecx & (1 << 16))
+		| kstd::switch_flag(FeatureFlags::FSRM, edx & (1 << 4));
 }
 
 static void cpuid__extended(ArchInfo& info)
@@ -97,9 +125,17 @@ static void cpuid__extended(ArchInfo& info)
 		| kstd::switch_flag(ExtFeatureFlags::Page_1Gb, (edx & (1<<26)))
 		| kstd::switch_flag(ExtFeatureFlags::LongMode, (edx & (1<<29)));
 
+	leaf = 0x80000007;
+	if (leaf > max_extended_leaf)
+		return;
+	CPUID();
+	info.ext_feature_flags = info.ext_feature_flags
+		| kstd::switch_flag(ExtFeatureFlags::InvariantTSC, edx & (1<<8));
+
 	leaf = 0x80000008;
 	if (leaf > max_extended_leaf)
 		return;
+	CPUID();
 
 	info.max_phy_addr = eax & 0xFF;
 	info.max_lin_addr = (eax & 0xFF00) >> 8;
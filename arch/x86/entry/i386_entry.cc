@@ -14,6 +14,7 @@
 #include <x86/paging.h>
 #include <x86/system.h>
 #include <x86/boot/setup.h>
+#include <x86/boot/early_arena.h>
 
 #include <kstd/new.h>
 #include <kstd/io.h>
@@ -27,21 +28,50 @@
 namespace x86 {
 
 enum class LocalErr {
-	None = 0, IdentityMapFail, KernelMapFail,
+	None = 0, EarlyMemFail, IdentityMapFail, KernelMapFail, DirectMapFail,
 };
 
 static void print_vendor_info(ArchInfo &arch_info, utils::VGA_OStream& os);
 static bool try_x86_cpuid_verbose(ArchInfo& arch_info, utils::VGA_OStream& os);
-static kstd::MemoryRange find_free_memory(const BootInfo& boot_info,
-		uintptr_t min_addr, unsigned int alignment);
+static LocalErr setup_early_arena(BootInfo& boot_info);
 
-static PageMapErr map_pages__free_mem(BootInfo& boot_info, PageMappingInfo& map_info,
-		PageTable *page_table, uintptr_t& min_addr);
-static LocalErr identity_map_pages(BootInfo& boot_info, PageTable *page_table, uintptr_t& min_addr);
-static LocalErr map_kernel_memory(BootInfo& boot_info, PageTable *page_table, uintptr_t& min_addr);
+static LocalErr identity_map_pages(PageTable *page_table,
+		PageTableAllocator& pt_allocator);
+static LocalErr map_kernel_memory(PageTable *page_table,
+		PageTableAllocator& pt_allocator);
+static LocalErr direct_map_ram(BootInfo& boot_info, PageTable *page_table,
+		PageTableAllocator& pt_allocator, PageSize max_page_size);
 
 static void setup_data_segments();
 
+/* Page tables allocated from the early arena. Paging isn't enabled yet,
+ * so they are accessed at their physical addresses. */
+class EarlyPageTableAllocator final : public PageTableAllocator {
+public:
+	explicit EarlyPageTableAllocator(EarlyArena& arena) : arena(arena) {}
+
+	PhysAddr alloc() override
+	{
+		const PhysAddr pt_addr = arena.alloc(PageTable::size, PageTable::size_shift);
+		if (pt_addr)
+			memset(to_virt(pt_addr), 0, PageTable::size);
+		return pt_addr;
+	}
+
+	void free(PhysAddr) override
+	{
+		// the arena can't take memory back, the page table just stays unused
+	}
+
+	void *to_virt(PhysAddr pt_addr) const override
+	{
+		return reinterpret_cast<void *>(static_cast<uintptr_t>(pt_addr));
+	}
+
+private:
+	EarlyArena& arena;
+};
+
 static inline void next_entry(BootInfo *boot_info);
 
 
@@ -73,31 +103,54 @@ extern "C" void _i386_start(x86::BootInfo *boot_info)
 		halt();
 	}
 
-	uintptr_t min_addr = kstd::max((uintptr_t)__ldsym__kernel_image_end_lma,
-			(uintptr_t)boot_info + boot_info->size);
-	kstd::MemoryRange pt_mem = find_free_memory(*boot_info, min_addr, PageTable::size_shift);
-	PageTable *page_table = reinterpret_cast<PageTable *>(pt_mem.beg);
-	new (page_table) PageTable();
-	min_addr += PageTable::size;
+	LocalErr e;
+	e = setup_early_arena(*boot_info);
+	if (e != LocalErr::None) {
+		os << red_on_black << "Failed to setup early memory.\n" << reset_color;
+		halt();
+	}
+
+	EarlyPageTableAllocator pt_allocator(boot_info->early_arena);
+	const PhysAddr pt_addr = pt_allocator.alloc();
+	if (!pt_addr) {
+		os << red_on_black << "No memory for the page table.\n" << reset_color;
+		halt();
+	}
+	PageTable *page_table = static_cast<PageTable *>(pt_allocator.to_virt(pt_addr));
 
 	os << "Current page table pointer: " << page_table << '\n';
 
-	LocalErr e;
-	e = identity_map_pages(*boot_info, page_table, min_addr);
+	e = identity_map_pages(page_table, pt_allocator);
 	if (e != LocalErr::None) {
 		os << red_on_black << "Failed to identity map pages.\n" << reset_color;
 		halt();
 	}
 
-	e = map_kernel_memory(*boot_info, page_table, min_addr);
+	e = map_kernel_memory(page_table, pt_allocator);
 	if (e != LocalErr::None) {
 		os << red_on_black << "Failed to map kernel memory.\n" << reset_color;
 		halt();
 	}
 
+	// 2Mb pages are supported by every 64bit capable CPU
+	const PageSize direct_map_page_size =
+		kstd::test_flag(arch_info.ext_feature_flags, ExtFeatureFlags::Page_1Gb)
+		? PageSize::_1Gb : PageSize::_2Mb;
+	e = direct_map_ram(*boot_info, page_table, pt_allocator, direct_map_page_size);
+	if (e != LocalErr::None) {
+		os << red_on_black << "Failed to map the physical memory.\n" << reset_color;
+		halt();
+	}
+
 	set_curr_pt_ptr((PhysAddr)page_table);
 	// TODO: check the cpuid features
 	enable_paging();
+	// the kernel mappings are global, so their TLB entries are kept
+	// across address space switches
+	if (kstd::test_flag(arch_info.feature_flags, FeatureFlags::PGE))
+		enable_global_pages();
+	// the 64bit code is compiled with SSE
+	enable_sse();
 
 	os << green_on_black << "Paging enabled!\n";
 	next_entry(boot_info);
@@ -130,61 +183,37 @@ static void print_vendor_info(ArchInfo& arch_info, utils::VGA_OStream& os)
 }
 
 
-static kstd::MemoryRange find_free_memory(const BootInfo& boot_info,
-		uintptr_t min_addr, unsigned int alignment)
+static LocalErr setup_early_arena(BootInfo& boot_info)
 {
-	for (size_t i = 0; boot_info.mmap.nr_entries; ++i){ 
-		auto& entry = boot_info.mmap.entries[i];
-		if (entry.type != arch::PhysicalMMapType::RAM)
-			continue;
-		uintptr_t end_addr = entry.base_addr + entry.length;
-		if (end_addr <= min_addr)
-			continue;
-
-		uintptr_t start_addr = kstd::max(min_addr, entry.base_addr);
-		start_addr = kstd::align_ceiled(start_addr, alignment);
-		end_addr = kstd::align_floored(end_addr, alignment);
-		if (start_addr >= end_addr)
-			continue;
-		return kstd::MemoryRange((kstd::Byte *)start_addr, (kstd::Byte *)end_addr);
-	}
-	return {};
-}
-
-static PageMapErr map_pages__free_mem(BootInfo& boot_info, PageMappingInfo& map_info,
-		PageTable *page_table, uintptr_t& min_addr)
-{
-	while (true) {
-		kstd::MemoryRange free_mem = find_free_memory(boot_info, min_addr,
-				PageTableEntry_<1>::controlled_bits);
-		if (free_mem.beg >= free_mem.end)
-			return PageMapErr::NoFreeMem;
-		PageMapErr e = page_table->map_memory(map_info, free_mem);
-		min_addr = (uintptr_t)free_mem.beg;
-		if (e != PageMapErr::NoFreeMem)
-			return e;
-		if (e == PageMapErr::None)
-			break;
-	}
-	return PageMapErr::None;
+	EarlyArena& arena = boot_info.early_arena;
+	arena.init(boot_info.mmap.entries, boot_info.mmap.nr_entries);
+
+	// the memory below the kernel image is left to the firmware
+	const uintptr_t boot_info_addr = reinterpret_cast<uintptr_t>(&boot_info);
+	if (!arena.reserve(0, __ldsym__kernel_image_end_lma)
+	 || !arena.reserve(boot_info_addr, boot_info_addr + boot_info.size))
+		return LocalErr::EarlyMemFail;
+	return LocalErr::None;
 }
 
-static LocalErr identity_map_pages(BootInfo& boot_info, PageTable *page_table, uintptr_t& min_addr)
+static LocalErr identity_map_pages(PageTable *page_table,
+		PageTableAllocator& pt_allocator)
 {
 	PageMapErr e = PageMapErr::None;
 	PageMappingInfo map_info;
 
+	// the identity mapping is only needed while switching to the higher
+	// half, so unlike the kernel mappings it isn't global
 	map_info = {
 		.linaddr_beg = 0,
 		.phyaddr_beg = 0,
 		.phyaddr_end = __ldsym__kernel_image_start_lma,
-		.flags  = PageEntryFlags::Global
-			| PageEntryFlags::WriteAllowed
+		.flags  = PageEntryFlags::WriteAllowed
 			| PageEntryFlags::Supervisor
 			| PageEntryFlags::ExecuteDisabled,
 	};
 
-	e = map_pages__free_mem(boot_info, map_info, page_table, min_addr);
+	e = page_table->map_memory(map_info, pt_allocator);
 	if (e != PageMapErr::None)
 		return LocalErr::IdentityMapFail;
 
@@ -194,12 +223,12 @@ static LocalErr identity_map_pages(BootInfo& boot_info, PageTable *page_table, u
 		map_info.linaddr_beg = (LineAddr)segment.lma_start;
 		map_info.phyaddr_beg = (PhysAddr)segment.lma_start;
 		map_info.phyaddr_end = (PhysAddr)(segment.lma_start + segment.size);
-		map_info.flags = PageEntryFlags::Global | PageEntryFlags::Supervisor
+		map_info.flags = PageEntryFlags::Supervisor
 			| kstd::switch_flag(PageEntryFlags::WriteAllowed,
 				kstd::test_flag(segment.flags, kernel_image::SegmentFlag::Write))
 			| kstd::switch_flag(PageEntryFlags::ExecuteDisabled,
 				!kstd::test_flag(segment.flags, kernel_image::SegmentFlag::Executable));
-		e = map_pages__free_mem(boot_info, map_info, page_table, min_addr);
+		e = page_table->map_memory(map_info, pt_allocator);
 		if (e != PageMapErr::None)
 			return LocalErr::IdentityMapFail;
 	}
@@ -207,7 +236,8 @@ static LocalErr identity_map_pages(BootInfo& boot_info, PageTable *page_table, u
 	return LocalErr::None;
 }
 
-static LocalErr map_kernel_memory(BootInfo& boot_info, PageTable *page_table, uintptr_t& min_addr)
+static LocalErr map_kernel_memory(PageTable *page_table,
+		PageTableAllocator& pt_allocator)
 {
 	utils::VGA_OStream os;
 	auto segments = kernel_image::get_ldsym_main_segments();
@@ -222,13 +252,38 @@ static LocalErr map_kernel_memory(BootInfo& boot_info, PageTable *page_table, ui
 				kstd::test_flag(segment.flags, kernel_image::SegmentFlag::Write))
 			| kstd::switch_flag(PageEntryFlags::ExecuteDisabled,
 				!kstd::test_flag(segment.flags, kernel_image::SegmentFlag::Executable));
-		PageMapErr e = map_pages__free_mem(boot_info, map_info, page_table, min_addr);
+		PageMapErr e = page_table->map_memory(map_info, pt_allocator);
 		if (e != PageMapErr::None)
 			return LocalErr::KernelMapFail;
 	}
 	return LocalErr::None;
 }
 
+static LocalErr direct_map_ram(BootInfo& boot_info, PageTable *page_table,
+		PageTableAllocator& pt_allocator, PageSize max_page_size)
+{
+	for (size_t i = 0; i < boot_info.mmap.nr_entries; ++i) {
+		const auto& entry = boot_info.mmap.entries[i];
+		if (entry.type != arch::PhysicalMMapType::RAM)
+			continue;
+
+		PageMappingInfo map_info;
+		map_info.phyaddr_beg = kstd::align_ceiled((PhysAddr)entry.base_addr, 12);
+		map_info.phyaddr_end = kstd::align_floored((PhysAddr)(entry.base_addr + entry.length), 12);
+		if (map_info.phyaddr_beg >= map_info.phyaddr_end)
+			continue;
+		map_info.linaddr_beg = page_fit_linear_addr(direct_map_offset + map_info.phyaddr_beg);
+		map_info.flags = PageEntryFlags::Global | PageEntryFlags::Supervisor
+			| PageEntryFlags::WriteAllowed | PageEntryFlags::ExecuteDisabled;
+		map_info.max_page_size = max_page_size;
+
+		PageMapErr e = page_table->map_memory(map_info, pt_allocator);
+		if (e != PageMapErr::None)
+			return LocalErr::DirectMapFail;
+	}
+	return LocalErr::None;
+}
+
 
 static inline void setup_data_segments()
 {
@@ -0,0 +1,12 @@
+#include <kstd/new.h>
+
+/* The entry code has no heap. The deallocation functions are only
+ * referenced by virtual destructors and never really called. */
+
+void operator delete(void *ptr) noexcept
+{
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+}
@@ -26,6 +26,12 @@ using LineSize = uint32_t;
 using LinePageN = uint32_t;
 #endif
 
+#if CONFIG_ARCH == ARCH_x86_64
+/* Linear address the physical address 0 is mapped at in the direct map
+ * of the physical memory. */
+constexpr LineAddr direct_map_offset = CONFIG_x86_DIRECT_MAP_OFFSET;
+#endif
+
 }
 
 #endif
@@ -0,0 +1,68 @@
+#ifndef _x86_BOOT__EARLY_ARENA_H__
+#define _x86_BOOT__EARLY_ARENA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/boot/setup.h>
+#include <x86/addressing.h>
+
+#include <kstd/memory.h>
+
+namespace x86 {
+
+/* Bump allocator of the physical memory used before the kernel has its own
+ * memory management. It keeps the RAM regions of the memory map sorted and
+ * merged, and allocating just moves the beginning of the current region,
+ * so the regions always describe the memory that is still free.
+ * It's written by the 32bit entry code and handed over to the kernel
+ * as part of the boot info, so it has a fixed width layout. */
+class EarlyArena {
+public:
+	using Region = arch::PhysicalMMap::Entry;
+
+	static constexpr unsigned int max_nr_regions = 128;
+
+	/* Setup the arena with the RAM entries of the memory map. */
+	void init(const Region *entries, size_t nr_entries);
+
+	/* Exclude the memory [beg, end) from the arena.
+	 * Returns false if there is no room for the region split it needs. */
+	bool reserve(PhysAddr beg, PhysAddr end);
+
+	/* Allocate size bytes aligned to 2^align_shift from memory addressable
+	 * before paging is enabled. Returns 0 on failure. */
+	PhysAddr alloc(size_t size, unsigned int align_shift);
+
+	/* Get the regions of the free memory. */
+	const Region *get_regions() const
+	{
+		return regions;
+	}
+
+	size_t get_nr_regions() const
+	{
+		return static_cast<size_t>(nr_regions);
+	}
+
+private:
+	/* Get the free memory of the current region, at least min_size large
+	 * after aligning its beginning to 2^align_shift.
+	 * Returns an empty range on failure. */
+	kstd::MemoryRange acquire_range(size_t min_size, unsigned int align_shift);
+	/* Make the rest of the range got from acquire_range the current region. */
+	void release_range(const kstd::MemoryRange& rest);
+
+	void insert_region(uint64_t idx, const Region& region);
+	void remove_region(uint64_t idx);
+
+	uint64_t nr_regions;
+	/* Region allocations are made from. Allocation never goes back to
+	 * the regions before it, whatever is left in them stays free. */
+	uint64_t curr_region;
+	Region regions[max_nr_regions];
+};
+
+}
+
+#endif
@@ -5,14 +5,43 @@
 #include <stdint.h>
 
 #include <arch/boot/setup.h>
+#include <x86/boot/early_arena.h>
 
 
 namespace x86 {
 
+/* Pointer stored as a 64bit value. The boot info is written by the 32bit
+ * entry code and read by the 64bit kernel, so both must agree on its layout. */
+template<typename T>
+struct BootPtr {
+	uint64_t addr;
+
+	BootPtr& operator=(T *ptr)
+	{
+		addr = reinterpret_cast<uintptr_t>(ptr);
+		return *this;
+	}
+
+	operator T *() const
+	{
+		return reinterpret_cast<T *>(static_cast<uintptr_t>(addr));
+	}
+
+	T *operator->() const
+	{
+		return *this;
+	}
+};
+
 struct BootInfo {
-	size_t size;
-	const char *boot_cmd;
-	arch::PhysicalMMap mmap;
+	uint64_t size;
+	BootPtr<const char> boot_cmd;
+	struct {
+		BootPtr<arch::PhysicalMMap::Entry> entries;
+		uint64_t nr_entries;
+	} mmap;
+	/* Memory left free by the entry code. */
+	EarlyArena early_arena;
 };
 
 }
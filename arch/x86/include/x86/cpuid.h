@@ -1,6 +1,8 @@
 #ifndef _x86__CPUID_H__
 #define _x86__CPUID_H__
 
+#include <stdint.h>
+
 #include <kstd/enum.h>
 
 namespace x86 {
@@ -19,6 +21,25 @@ enum class FeatureFlags {
 	SMAP = 	SMEP << 1,
 	/* 57bit linear addresses and 5-level paging. */
 	LA57 = 	SMAP << 1,
+	/* Process-context identifiers. */
+	PCID = 	LA57 << 1,
+	/* INVPCID instruction. */
+	INVPCID = PCID << 1,
+	/* Enhanced rep movsb and rep stosb. */
+	ERMS = 	INVPCID << 1,
+	/* Fast short rep movsb. */
+	FSRM = 	ERMS << 1,
+	SSE2 = 	FSRM << 1,
+	/* XSAVE and the XCR0 register. */
+	XSAVE = SSE2 << 1,
+	AVX = 	XSAVE << 1,
+	AVX2 = 	AVX << 1,
+	/* Local APIC. */
+	APIC = 	AVX2 << 1,
+	/* Local APIC registers accessed as MSRs. */
+	x2APIC = APIC << 1,
+	/* Local APIC timer firing at a TSC value. */
+	TSC_Deadline = x2APIC << 1,
 };
 KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(FeatureFlags);
 
@@ -31,6 +52,8 @@ enum class ExtFeatureFlags {
 	Page_1Gb = 	NX << 1,
 	/* Long mode support. */
 	LongMode = 	Page_1Gb << 1,
+	/* TSC running at a constant rate in all power states. */
+	InvariantTSC = 	LongMode << 1,
 };
 KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(ExtFeatureFlags);
 
@@ -43,6 +66,11 @@ struct ArchInfo {
 	unsigned short max_lin_addr; /* Max number of linear address bits. */
 };
 
+/* Registers returned by a single CPUID leaf. */
+struct CPUID_Leaf {
+	uint32_t eax, ebx, ecx, edx;
+};
+
 
 /* Check if CPUID is present. */
 bool check_cpuid_presence();
@@ -52,6 +80,9 @@ bool cpuid(ArchInfo& info);
 /* Get current x86 architecture info from CPUID.
  * Doesn't check CPUID presence. */
 void cpuid__assume_cpuid_present(ArchInfo& info);
+/* Query a single CPUID leaf, all zeros if it's past the last one.
+ * Doesn't check CPUID presence. */
+CPUID_Leaf read_cpuid_leaf(uint32_t leaf, uint32_t subleaf = 0);
 
 }
 
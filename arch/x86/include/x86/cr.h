@@ -3,6 +3,7 @@
 
 #include <compiler_attributes.h>
 #include <kstd/enum.h>
+#include <x86/msr.h>
 
 namespace x86 {
 
@@ -70,8 +71,6 @@ enum class EFER_Flags : unsigned long {
 };
 KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(EFER_Flags);
 
-constexpr auto efer_msr_num = 0xC0000080;
-
 __FORCE_INLINE unsigned long read_cr0()
 {
 	unsigned long val;
@@ -84,6 +83,14 @@ __FORCE_INLINE void write_cr0(unsigned long val)
 	asm volatile ("mov %0, %%cr0" :: "r"(val) : "memory");
 }
 
+/* Address the last page fault happened at. */
+__FORCE_INLINE unsigned long read_cr2()
+{
+	unsigned long val;
+	asm volatile ("mov %%cr2, %0" : "=r"(val));
+	return val;
+}
+
 __FORCE_INLINE unsigned long read_cr3()
 {
 	unsigned long val;
@@ -110,22 +117,12 @@ __FORCE_INLINE void write_cr4(unsigned long val)
 
 __FORCE_INLINE unsigned long read_efer()
 {
-	unsigned val;
-	asm volatile ( 	"mov %[msr_efer], %%ecx 	\n"
-			"rdmsr"
-			: "=a"(val)
-			: [msr_efer] "i" (efer_msr_num)
-			: "memory");
-	return val;
+	return read_msr(MSR::EFER);
 }
 
 __FORCE_INLINE void write_efer(unsigned long val)
 {
-	asm volatile ( 	"mov %[msr_efer], %%ecx 	\n"
-			"mov %[val], %%eax 		\n"
-			"wrmsr"
-			:: [msr_efer] "i" (efer_msr_num), [val] "r" (val)
-			: "memory");
+	write_msr(MSR::EFER, val);
 }
 
 __FORCE_INLINE CR0_Flags read_cr0_flags()
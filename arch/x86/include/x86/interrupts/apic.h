@@ -0,0 +1,87 @@
+#ifndef _x86_INTERRUPTS__APIC_H__
+#define _x86_INTERRUPTS__APIC_H__
+
+#include <stdint.h>
+
+#include <x86/addressing.h>
+
+namespace x86 {
+
+/* Local APIC registers, numbered as the x2APIC MSRs are. The xAPIC ones are
+ * at 16 times the number in its MMIO page. */
+enum class APIC_Reg : uint16_t {
+	ID 			= 0x02,
+	Version 		= 0x03,
+	TaskPriority 		= 0x08,
+	EOI 			= 0x0B,
+	SpuriousVector 		= 0x0F,
+	ErrorStatus 		= 0x28,
+	InterruptCommand 	= 0x30,
+	InterruptCommandHigh 	= 0x31, /* Only in the xAPIC mode. */
+	LVT_Timer 		= 0x32,
+	LVT_Thermal 		= 0x33,
+	LVT_PerfMon 		= 0x34,
+	LVT_LINT0 		= 0x35,
+	LVT_LINT1 		= 0x36,
+	LVT_Error 		= 0x37,
+	TimerInitialCount 	= 0x38,
+	TimerCurrentCount 	= 0x39,
+	TimerDivide 		= 0x3E,
+};
+
+/* Vectors of the interrupts raised by the local APIC itself. */
+constexpr unsigned int apic_timer_vector = 0xEF;
+constexpr unsigned int apic_error_vector = 0xFE;
+constexpr unsigned int apic_spurious_vector = 0xFF;
+
+/* Delivery modes of the local vector table and of IPIs. */
+enum class APIC_Delivery : uint32_t {
+	Fixed 	= 0x000,
+	NMI 	= 0x400,
+	INIT 	= 0x500,
+	StartUp = 0x600,
+	ExtINT 	= 0x700,
+};
+
+/* Local vector table entry bits. */
+constexpr uint32_t apic_lvt_masked = 1 << 16;
+
+/* Destinations of an IPI besides a single APIC id. */
+enum class IPI_Dest : uint32_t {
+	Single 		= 0x00000,
+	Self 		= 0x40000,
+	All 		= 0x80000,
+	AllButSelf 	= 0xC0000,
+};
+
+/* Physical address of the xAPIC registers, the same for all CPUs. */
+PhysAddr get_apic_phys_addr();
+
+/* Enable the local APIC of the current CPU with all of its local interrupts
+ * masked. It's switched to the x2APIC mode if xapic_regs is null, the CPU
+ * must support it then. The first CPU decides the mode for all of them. */
+void setup_apic(volatile uint32_t *xapic_regs);
+
+bool is_x2apic_enabled();
+
+uint32_t read_apic(APIC_Reg reg);
+void write_apic(APIC_Reg reg, uint32_t val);
+
+/* Signal the end of the interrupt being handled. Not for the spurious
+ * vector. */
+void apic_eoi();
+
+uint32_t get_apic_id();
+
+/* Program a local vector table entry, masked if vector is 0. */
+void set_apic_lvt(APIC_Reg lvt, unsigned int vector,
+		APIC_Delivery delivery = APIC_Delivery::Fixed);
+
+/* Send an interrupt to other CPUs, apic_id is only used with
+ * IPI_Dest::Single. */
+void send_ipi(IPI_Dest dest, uint32_t apic_id, unsigned int vector,
+		APIC_Delivery delivery = APIC_Delivery::Fixed);
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef _x86_INTERRUPTS__IDT_H__
+#define _x86_INTERRUPTS__IDT_H__
+
+#include <stdint.h>
+
+namespace x86 {
+
+/* Vectors of the CPU exceptions. */
+enum class Exception : uint8_t {
+	DivideError 		= 0,
+	Debug 			= 1,
+	NMI 			= 2,
+	Breakpoint 		= 3,
+	Overflow 		= 4,
+	BoundRange 		= 5,
+	InvalidOpcode 		= 6,
+	DeviceNotAvailable 	= 7,
+	DoubleFault 		= 8,
+	InvalidTSS 		= 10,
+	SegmentNotPresent 	= 11,
+	StackFault 		= 12,
+	GeneralProtection 	= 13,
+	PageFault 		= 14,
+	x87FloatingPoint 	= 16,
+	AlignmentCheck 		= 17,
+	MachineCheck 		= 18,
+	SIMDFloatingPoint 	= 19,
+	Virtualization 		= 20,
+	ControlProtection 	= 21,
+};
+
+constexpr unsigned int nr_vectors = 256;
+/* Vectors below this one are reserved for exceptions. */
+constexpr unsigned int first_interrupt_vector = 32;
+
+/* Vectors the legacy PIC is moved to, so it can't raise exceptions. */
+constexpr unsigned int legacy_pic_vector = 0x20;
+/* Vector with an empty handler the interrupt cost is measured with. */
+constexpr unsigned int benchmark_vector = 0xF0;
+
+/* Registers of the interrupted code saved on exceptions, in the order they
+ * are on the stack. */
+struct InterruptFrame {
+	uint64_t r15, r14, r13, r12, r11, r10, r9, r8;
+	uint64_t rbp, rdi, rsi, rdx, rcx, rbx, rax;
+	uint64_t vector;
+	uint64_t error_code; /* 0 for exceptions without one */
+	uint64_t rip, cs, rflags, rsp, ss;
+};
+
+/* Handler of an exception, it gets all registers of the interrupted code. */
+using ExceptionHandler = void (*)(InterruptFrame *frame);
+
+/* Handler of the vectors above the exceptions. Only the registers a function
+ * call may clobber are saved around it, which keeps interrupts cheap. */
+using InterruptHandler = void (*)(unsigned int vector);
+
+/* Called once on an unhandled exception before it's reported, to write out
+ * what's buffered for the console. */
+using PanicHook = void (*)();
+
+/* Load the IDT. Exceptions halt the kernel until they are given a handler,
+ * interrupt vectors without one are ignored. Vector registers are saved
+ * whole, so setup AVX before. */
+void setup_interrupts();
+
+void set_exception_handler(Exception exception, ExceptionHandler handler);
+
+void set_interrupt_handler(unsigned int vector, InterruptHandler handler);
+
+void set_panic_hook(PanicHook hook);
+
+/* Enter and leave the empty handler of the benchmark vector. */
+inline void raise_benchmark_interrupt()
+{
+	asm volatile ("int %[vector]" :: [vector]"i"(benchmark_vector) : "memory");
+}
+
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef _x86_INTERRUPTS__PIC_H__
+#define _x86_INTERRUPTS__PIC_H__
+
+namespace x86 {
+
+/* Move the vectors of the legacy 8259 PICs past the exceptions and mask all
+ * their interrupt lines. The firmware leaves them raising interrupts on the
+ * vectors of exceptions. */
+void disable_legacy_pic();
+
+}
+
+#endif
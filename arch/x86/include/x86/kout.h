@@ -2,12 +2,21 @@
 #define _x86__KOUT_H__
 
 #include <kstd/io.h>
+#include <x86/config.h>
+
+#if CONFIG_x86_KERNEL_OSTREAM == x86_KERNEL_OSTREAM_SERIAL
+#include <x86/utils/serial/ostream.h>
+#else
 #include <x86/utils/vga/ostream.h>
+#endif
 
 namespace x86 {
 
-// the default output stream for now
+#if CONFIG_x86_KERNEL_OSTREAM == x86_KERNEL_OSTREAM_SERIAL
+using KernelOStream = utils::Serial_OStream;
+#else
 using KernelOStream = utils::VGA_OStream;
+#endif
 inline KernelOStream kout;
 
 }
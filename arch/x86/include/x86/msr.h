@@ -0,0 +1,33 @@
+#ifndef _x86__MSR_H__
+#define _x86__MSR_H__
+
+#include <stdint.h>
+
+#include <compiler_attributes.h>
+
+namespace x86 {
+
+/* Model specific registers in use. */
+enum class MSR : uint32_t {
+	APIC_Base 	= 0x1B,
+	TSC_Deadline 	= 0x6E0,
+	x2APIC_Base 	= 0x800, /* First x2APIC register. */
+	EFER 		= 0xC0000080,
+};
+
+__FORCE_INLINE uint64_t read_msr(MSR msr)
+{
+	uint32_t low, high;
+	asm volatile ("rdmsr" : "=a"(low), "=d"(high) : "c"(static_cast<uint32_t>(msr)));
+	return (uint64_t(high) << 32) | low;
+}
+
+__FORCE_INLINE void write_msr(MSR msr, uint64_t val)
+{
+	asm volatile ("wrmsr" :: "c"(static_cast<uint32_t>(msr)),
+			"a"(uint32_t(val)), "d"(uint32_t(val >> 32)) : "memory");
+}
+
+}
+
+#endif
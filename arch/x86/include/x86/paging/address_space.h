@@ -0,0 +1,61 @@
+#ifndef _x86_PAGING__ADDRESS_SPACE_H__
+#define _x86_PAGING__ADDRESS_SPACE_H__
+
+#include <stdint.h>
+
+#include <x86/addressing.h>
+#include <x86/paging/tlb.h>
+
+namespace x86 {
+
+/* Page tables of an address space. */
+class AddressSpace {
+public:
+	explicit AddressSpace(PhysAddr pt_addr);
+
+	PhysAddr get_page_table_addr() const
+	{
+		return pt_addr;
+	}
+
+private:
+	friend class TLBContext;
+
+	PhysAddr pt_addr;
+	/* Unique id of the address space. Unlike PCIDs it's never reused,
+	 * so a CPU can tell whether a PCID still tags this address space. */
+	uint64_t ctx_id;
+};
+
+/* TLB state of a CPU: its current address space and the PCIDs assigned to
+ * the recently used ones. Switching back to an address space that still
+ * has its PCID keeps its TLB entries, the least recently used PCID is
+ * reassigned otherwise. Each CPU needs its own context. */
+class TLBContext {
+public:
+	/* Number of PCIDs handed out, PCID 0 is left to the boot page tables. */
+	static constexpr unsigned int nr_pcids = 6;
+
+	/* Make as the current address space of the CPU. */
+	void switch_to(AddressSpace& as);
+
+	/* Invalidate the pages of tlb_batch, which were changed in as. */
+	void flush(AddressSpace& as, TLBFlushBatch& tlb_batch);
+
+private:
+	struct Slot {
+		uint64_t ctx_id = 0; /* Address space tagged with the PCID, 0 if none. */
+		uint64_t last_used = 0;
+	};
+
+	/* Get the PCID of the address space, 0 if it has none. */
+	unsigned long find_pcid(const AddressSpace& as) const;
+
+	AddressSpace *curr_as = nullptr;
+	uint64_t clock = 0;
+	Slot slots[nr_pcids];
+};
+
+}
+
+#endif
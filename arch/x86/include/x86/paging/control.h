@@ -73,6 +73,12 @@ __FORCE_INLINE void enable_paging_level_5()
 	enable_paging__common();
 }
 
+/* Make the TLB entries of the global pages survive CR3 loads. */
+__FORCE_INLINE void enable_global_pages()
+{
+	write_cr4_flags(read_cr4_flags() | CR4_Flags::PGE);
+}
+
 __FORCE_INLINE void enable_paging()
 {
 #if CONFIG_x86_PAGE_MAP_LEVEL == x86_PAGE_MAP_LEVEL_2
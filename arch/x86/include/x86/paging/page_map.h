@@ -4,6 +4,7 @@
 
 #include <x86/config.h>
 #include <x86/addressing.h>
+#include <x86/paging/tlb.h>
 #include <stddef.h>
 #include <kstd/either.h>
 #include <kstd/enum.h>
@@ -40,6 +41,8 @@ enum class PageEntryFlags {
 	Supervisor = WriteAllowed << 1,
 	Global = Supervisor << 1,
 	ExecuteDisabled = Global << 1,
+	/* Accesses go around the caches, for device registers. */
+	CacheDisabled = ExecuteDisabled << 1,
 };
 KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(PageEntryFlags);
 
@@ -146,6 +149,30 @@ struct PageMappingInfo {
 	PhysAddr phyaddr_end; /* Ending physical address. */
 	PageSize page_size; /* Page size. Specify it only for functions that require it. */
 	PageEntryFlags flags; /* Page entry flags. */
+	/* Largest page size map_memory is allowed to use. */
+	PageSize max_page_size = page_sizes[num_page_sizes - 1];
+};
+
+/* Result of translating a linear address. */
+struct PageTranslation {
+	PhysAddr phyaddr; /* Physical address the linear address is mapped to. */
+	PageSize page_size; /* Size of the page the linear address belongs to. */
+	PageEntryFlags flags; /* Flags of the page. */
+};
+
+/* Memory page tables are allocated from and given back to. */
+class PageTableAllocator {
+public:
+	/* Allocate a page table, PageTable_::size large and aligned, with all
+	 * of its entries cleared. Returns 0 on failure. */
+	virtual PhysAddr alloc() = 0;
+	/* Give back the memory of a page table that isn't linked anymore. */
+	virtual void free(PhysAddr pt_addr) = 0;
+	/* Get the address the page table at pt_addr can be accessed at. */
+	virtual void *to_virt(PhysAddr pt_addr) const = 0;
+
+protected:
+	~PageTableAllocator() = default;
 };
 
 /* Class representing a page table with given page map level
@@ -158,26 +185,49 @@ public:
 	/* Map linear address memory
 	 * [info.linaddr_beg; info.linaddr_beg + (info.phyaddr_end - info.phyaddr_beg)) to
 	 * physical address memory   [info.phyaddr_beg, info.phyaddr_end)
-	 * given the free physical memory [free_mem.beg, free_mem.end)
-	 * where page tables can be stored.
+	 * allocating the page tables from the given allocator.
 	 * Mapped pages may have different sizes if necessary.
 	 * In case of any error, especially PageMapErr::NoFreeMem, the info struct
 	 * will be updated to contain the linear and physical addresses at which
-	 * mapping failed and the free_mem will contain the rest of the free memory
-	 * used for mapping. */
-	PageMapErr map_memory(PageMappingInfo& info, kstd::MemoryRange& free_mem);
+	 * mapping failed. */
+	PageMapErr map_memory(PageMappingInfo& info, PageTableAllocator& allocator);
 
 	/* Map pages the size of page_size of linear address memory
 	 * [info.linaddr_beg; info.linaddr_beg + (info.phyaddr_end - info.phyaddr_beg)) to
 	 * physical address memory   [info.phyaddr_beg, info.phyaddr_end)
-	 * given the free physical memory [free_mem.beg, free_mem.end)
-	 * where page tables can be stored.
-	 * Mapped pages may have different sizes if necessary.
+	 * allocating the page tables from the given allocator.
 	 * In case of any error, especially PageMapErr::NoFreeMem, the info struct
 	 * will be updated to contain the linear and physical addresses at which
-	 * mapping failed and the free_mem will contain the rest of the free memory
-	 * used for mapping. */
-	PageMapErr map_pages(PageMappingInfo& info, kstd::MemoryRange& free_mem);
+	 * mapping failed. */
+	PageMapErr map_pages(PageMappingInfo& info, PageTableAllocator& allocator);
+
+	/* Unmap the linear address memory [linaddr_beg, linaddr_end). Both
+	 * addresses have to be page aligned, the memory that isn't mapped is
+	 * skipped. Large pages covered only partially are split first, which is
+	 * the only case PageMapErr::NoFreeMem can be returned in. Page tables
+	 * left without any mapping are given back to the allocator by
+	 * tlb_batch. The unmapped pages are added to tlb_batch, which has to be
+	 * flushed before the unmapped memory is reused. */
+	PageMapErr unmap_range(LineAddr linaddr_beg, LineAddr linaddr_end,
+			PageTableAllocator& allocator, TLBFlushBatch& tlb_batch);
+
+	/* Change the flags of the pages mapped in the linear address memory
+	 * [linaddr_beg, linaddr_end). Both addresses have to be page aligned,
+	 * the memory that isn't mapped is skipped. Large pages covered only
+	 * partially are split first. Page tables ending up mapping physically
+	 * contiguous memory with the same flags are merged back into large
+	 * pages not larger than max_page_size and given back to the allocator
+	 * by tlb_batch. The changed pages are added to tlb_batch as with
+	 * unmap_range. */
+	PageMapErr protect_range(LineAddr linaddr_beg, LineAddr linaddr_end,
+			PageEntryFlags flags, PageTableAllocator& allocator,
+			TLBFlushBatch& tlb_batch,
+			PageSize max_page_size = page_sizes[num_page_sizes - 1]);
+
+	/* Get the physical address and the page the linear address is mapped
+	 * to, nothing if it isn't mapped. */
+	kstd::Maybe<PageTranslation> translate(LineAddr linaddr,
+			const PageTableAllocator& allocator) const;
 
 	const PageTableEntry_<pml> *observe() const;
 
@@ -196,20 +246,48 @@ public:
 private:
 	/* Same as map_pages__no_mm but the _no_chk suffix means it won't check
 	 * linaddr_beg and phyaddr_beg alignments and whether any overflow might happen. */
-	PageMapErr map_pages__no_chk(PageMappingInfo& info, kstd::MemoryRange& free_mem);
+	PageMapErr map_pages__no_chk(PageMappingInfo& info, PageTableAllocator& allocator);
 
 	/* Same as map_pages__no_mm_no_chk but the page_size is a compile time constant. */
 	template<PageSize page_size>
-	PageMapErr map_pages__const_ps(PageMappingInfo& info, kstd::MemoryRange& free_mem);
+	PageMapErr map_pages__const_ps(PageMappingInfo& info, PageTableAllocator& allocator);
+
+	/* Recursive parts of unmap_range and protect_range without the argument
+	 * checks. They advance linaddr_beg past the memory they are done with. */
+	PageMapErr unmap_range__no_chk(LineAddr& linaddr_beg, LineAddr linaddr_end,
+			PageTableAllocator& allocator, TLBFlushBatch& tlb_batch);
+	PageMapErr protect_range__no_chk(LineAddr& linaddr_beg, LineAddr linaddr_end,
+			PageEntryFlags flags, PageTableAllocator& allocator,
+			TLBFlushBatch& tlb_batch, PageSize max_page_size);
 
 	/* Check if linear and physical addresses will overflow during mapping. */
 	static PageMapErr check_overflow(LineAddr linaddr_beg, PhysAddr phyaddr_beg,
 			PhysAddr phyaddr_end);
+	/* Check the linear address range given to unmap_range or protect_range. */
+	static PageMapErr check_range(LineAddr linaddr_beg, LineAddr linaddr_end);
 
 	/* Get a page table that the given entry links to if it does, otherwise
-	 * create, map and get a new page table using the given free memory range. */
+	 * create, map and get a new page table using the given allocator. */
 	static kstd::Either<PageTable_<pml - 1> *, PageMapErr> get_or_map_page_table(
-			PageTableEntry_<pml>& entry, kstd::MemoryRange& free_mem);
+			PageTableEntry_<pml>& entry, PageTableAllocator& allocator);
+
+	/* Get the page table the given entry links to. */
+	static PageTable_<pml - 1> *get_page_table(const PageTableEntry_<pml>& entry,
+			const PageTableAllocator& allocator);
+
+	/* Replace the large page mapped by the entry with a page table mapping
+	 * the same memory with the pages of the size one level below. */
+	static PageMapErr split_page(PageTableEntry_<pml>& entry,
+			PageTableAllocator& allocator);
+
+	/* Replace the page table the entry links to with a single large page
+	 * at linaddr if its pages map physically contiguous memory with
+	 * the same flags. */
+	static void try_merge_page_table(PageTableEntry_<pml>& entry, LineAddr linaddr,
+			PageTableAllocator& allocator, TLBFlushBatch& tlb_batch);
+
+	/* Whether no entry of the table is present. */
+	bool is_empty() const;
 
 	/* The exact array of entries. */
 	alignas(sizeof(PageTableEntryValue) * nr_entries)
@@ -223,9 +301,10 @@ inline const PageTableEntry_<pml> *PageTable_<pml>::observe() const
 }
 
 constexpr kstd::Maybe<PageSize> find_max_page_size(
-		LineAddr linaddr_beg, PhysAddr phyaddr_beg, size_t size_limit)
+		LineAddr linaddr_beg, PhysAddr phyaddr_beg, PhysSize size_limit,
+		PageSize max_page_size = page_sizes[num_page_sizes - 1])
 {
-	for (int i = num_page_sizes - 1; i >= 0; --i) {
+	for (int i = (int)max_page_size; i >= 0; --i) {
 		PageSize page_size = page_sizes[i];
 		auto page_size_bytes = get_page_size_bytes(page_size);
 
@@ -249,6 +328,20 @@ static constexpr LineAddr page_fit_linear_addr(LineAddr addr)
 	return addr & (PageTable::controlled_mem - 1);
 }
 
+/* Inverse of page_fit_linear_addr, the bits above the ones a page table
+ * controls are set to the highest of them, as INVLPG and INVPCID need. */
+static constexpr LineAddr canonical_linear_addr(LineAddr addr)
+{
+	// nothing to extend if the page table controls all of the bits
+	const LineAddr high_bits = ~(PageTable::controlled_mem - 1);
+	return addr & (PageTable::controlled_mem >> 1) ? addr | high_bits : addr & ~high_bits;
+}
+
+#if CONFIG_ARCH == ARCH_x86_64
+static_assert(canonical_linear_addr(page_fit_linear_addr(direct_map_offset)) == direct_map_offset,
+		"Pages of the direct map must be invalidated at their own address.");
+#endif
+
 }
 
 #endif
@@ -22,6 +22,8 @@ constexpr auto pte_l2_page_mask_high = (uint32_t(1) << 21) - (1 << 13);
 
 constexpr auto max_possible_phyaddr_bits = 40;
 
+constexpr auto max_pml_having_ps_bit = 2;
+
 }
 
 template<int pml> inline bool PageTableEntry_<pml>::is_present() const
@@ -96,7 +98,8 @@ inline void PageTableEntry_<pml>::map_page(PhysAddr page_addr, bool global)
 	}
 	value &= ~constants::pte_page_mask;
 	value |= page_addr_fields;
-	value |= int(global) << constants::pte_g_bit_loc;
+	value = (value & ~(PageTableEntryValue(1) << constants::pte_g_bit_loc))
+		| (PageTableEntryValue(global) << constants::pte_g_bit_loc);
 
 	if (pml > 1)
 		value |= 1 << constants::pte_ps_bit_loc;
@@ -109,7 +109,8 @@ inline void PageTableEntry_<pml>::map_page(PhysAddr page_addr, bool global)
 	value |= page_addr;
 
 	if constexpr (pml <= constants::max_pml_having_global_bit)
-		value |= int(global) << constants::pte_g_bit_loc;
+		value = (value & ~(PageTableEntryValue(1) << constants::pte_g_bit_loc))
+			| (PageTableEntryValue(global) << constants::pte_g_bit_loc);
 
 	if constexpr (1 < pml && pml <= constants::max_pml_having_ps_bit)
 		value |= 1 << constants::pte_ps_bit_loc;
@@ -42,6 +42,7 @@ struct PageTableEntry_ {
 	bool maps_page_table() const;
 	bool is_global() const;
 	bool is_execute_disabled() const;
+	bool is_cache_disabled() const;
 
 	void set_present(bool present);
 	void set_write_allowed(bool write_allowed);
@@ -49,6 +50,9 @@ struct PageTableEntry_ {
 	void map_page(PhysAddr page_addr, bool global);
 	void map_page_table(PhysAddr pt_addr);
 	void set_execute_disabled(bool execute_disable);
+	void set_cache_disabled(bool cache_disable);
+	/* Make the entry not present and drop everything it maps. */
+	void clear();
 
 	PhysAddr get_page_addr() const;
 	PhysAddr get_page_table_addr() const;
@@ -58,6 +62,25 @@ struct PageTableEntry_ {
 	PageTableEntryValue value;
 };
 
+template<int pml> inline void PageTableEntry_<pml>::clear()
+{
+	value = 0;
+}
+
+/* Page-level cache disable bit, at the same place in all paging modes. */
+constexpr auto pte_pcd_bit_loc = 4;
+
+template<int pml> inline bool PageTableEntry_<pml>::is_cache_disabled() const
+{
+	return !!(value & (1 << pte_pcd_bit_loc));
+}
+
+template<int pml> inline void PageTableEntry_<pml>::set_cache_disabled(bool cache_disable)
+{
+	static constexpr auto mask = (PageTableEntryValue)1 << pte_pcd_bit_loc;
+	value = (value & ~mask) | (mask * cache_disable);
+}
+
 }
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef _x86_PAGING__PAGE_TABLE_POOL_H__
+#define _x86_PAGING__PAGE_TABLE_POOL_H__
+
+#include <x86/addressing.h>
+#include <x86/paging/page_map.h>
+
+namespace x86 {
+
+/* Page table allocator keeping a pool of frames zeroed in advance, so
+ * creating a page table on the mapping path doesn't have to clear it.
+ * The pool is refilled with refill_one() whenever the CPU has nothing
+ * better to do, frames are zeroed on demand only once it runs dry.
+ * The pool isn't synchronized, its users have to serialize the calls. */
+class PageTablePool final : public PageTableAllocator {
+public:
+	using AllocFrame = PhysAddr (*)();
+	using FreeFrame = void (*)(PhysAddr frame);
+
+	static constexpr unsigned int capacity = 64;
+
+	/* Setup the pool with the functions frames are taken from and given
+	 * back with. */
+	void init(AllocFrame alloc_frame, FreeFrame free_frame);
+
+	PhysAddr alloc() override;
+	void free(PhysAddr pt_addr) override;
+	void *to_virt(PhysAddr pt_addr) const override;
+
+	/* Zero a frame and put it into the pool. Returns false if the pool is
+	 * full or no frame could be taken. */
+	bool refill_one();
+
+private:
+	/* Take a frame and zero it, around the caches if it's cold. */
+	PhysAddr alloc_zeroed_frame(bool cold);
+
+	AllocFrame alloc_frame = nullptr;
+	FreeFrame free_frame = nullptr;
+	unsigned int nr_frames = 0;
+	PhysAddr frames[capacity];
+};
+
+}
+
+#endif
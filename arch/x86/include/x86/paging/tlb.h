@@ -0,0 +1,108 @@
+#ifndef _x86_PAGING__TLB_H__
+#define _x86_PAGING__TLB_H__
+
+#include <x86/addressing.h>
+#include <x86/cpuid.h>
+#include <x86/cr.h>
+
+#include <compiler_attributes.h>
+
+namespace x86 {
+
+class PageTableAllocator;
+
+/* Invalidate the TLB entries of the page linaddr belongs to, whatever its
+ * size and whether it's global, along with the paging-structure caches. */
+__FORCE_INLINE void invlpg(LineAddr linaddr)
+{
+	asm volatile ("invlpg (%0)" :: "r"((uintptr_t)linaddr) : "memory");
+}
+
+/* INVPCID invalidation types. */
+enum class InvpcidType : unsigned long {
+	Address = 0, /* A non-global page of a PCID. */
+	Context = 1, /* The non-global pages of a PCID. */
+	AllGlobal = 2, /* All the pages of all PCIDs, the global ones too. */
+	All = 3, /* The non-global pages of all PCIDs. */
+};
+
+__FORCE_INLINE void invpcid(InvpcidType type, unsigned long pcid, LineAddr linaddr)
+{
+	const struct {
+		uint64_t pcid;
+		uint64_t linaddr;
+	} desc = { pcid, linaddr };
+	asm volatile ("invpcid %0, %1" :: "m"(desc), "r"((unsigned long)type) : "memory");
+}
+
+/* Flush the TLB entries of the non-global pages of the current PCID
+ * by reloading CR3. */
+__FORCE_INLINE void flush_tlb()
+{
+	write_cr3(read_cr3());
+}
+
+/* Setup the TLB features of the current CPU: PCIDs and INVPCID are used
+ * if supported. It has to be called while the PCID in CR3 is 0. */
+void setup_tlb(const ArchInfo& info);
+
+/* Whether CR4.PCIDE is set and CR3 holds a PCID. */
+bool is_pcid_enabled();
+/* Whether INVPCID is available. */
+bool is_invpcid_enabled();
+
+/* Flush the TLB entries of all the pages of all PCIDs, the global ones too. */
+void flush_tlb_global();
+
+/* Pages whose TLB entries have to be invalidated after their page table
+ * entries were changed. Page table operations append the pages they change
+ * and the batch invalidates them at once with flush(). A few pages are
+ * invalidated one by one, above max_nr_pages the whole TLB is flushed
+ * instead as refilling it gets cheaper than that many INVLPGs. Global
+ * pages are flushed along only if the batch has any. Page tables unlinked
+ * by the operations are only given back to their allocator after the
+ * flush, as the paging-structure caches may point to them until then. */
+class TLBFlushBatch {
+public:
+	static constexpr unsigned int max_nr_pages = 32;
+
+	/* Add the page linaddr belongs to, in the form page tables are walked
+	 * with, as page_fit_linear_addr gives. */
+	void add_page(LineAddr linaddr, bool global);
+
+	/* Give the page table at pt_addr, which was unlinked from the entry
+	 * mapping linaddr, back to the allocator once the batch is flushed.
+	 * The page tables of a batch come from the same allocator. */
+	void add_page_table(LineAddr linaddr, bool global, PhysAddr pt_addr,
+			PageTableAllocator& allocator);
+
+	/* Whether there's nothing to invalidate. */
+	bool is_empty() const
+	{
+		return nr_pages == 0;
+	}
+
+	/* Invalidate the TLB entries of the added pages and empty the batch. */
+	void flush();
+	/* Same as flush but the pages belong to an address space other than
+	 * the current one, whose TLB entries are tagged with pcid. Only the
+	 * global pages are invalidated if pcid is 0, as the address space
+	 * has no entries of its own in the TLB. Other PCIDs need INVPCID. */
+	void flush_other(unsigned long pcid);
+
+private:
+	void free_page_tables();
+
+	LineAddr pages[max_nr_pages];
+	/* Number of added pages, it's allowed to go past max_nr_pages. */
+	unsigned long nr_pages = 0;
+	bool has_global = false;
+	/* Page tables to free, each linking the next one with its first entry,
+	 * which stays not present as the address is page aligned. */
+	PhysAddr freed_page_tables = 0;
+	PageTableAllocator *pt_allocator = nullptr;
+};
+
+}
+
+#endif
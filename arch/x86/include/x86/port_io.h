@@ -0,0 +1,22 @@
+#ifndef _x86__PORT_IO_H__
+#define _x86__PORT_IO_H__
+
+#include <stdint.h>
+
+namespace x86 {
+
+inline uint8_t inb(uint16_t port)
+{
+	uint8_t val;
+	asm volatile ("inb %1, %0" : "=a"(val) : "Nd"(port));
+	return val;
+}
+
+inline void outb(uint16_t port, uint8_t val)
+{
+	asm volatile ("outb %0, %1" :: "a"(val), "Nd"(port));
+}
+
+}
+
+#endif
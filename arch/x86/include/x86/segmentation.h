@@ -0,0 +1,43 @@
+#ifndef _x86__SEGMENTATION_H__
+#define _x86__SEGMENTATION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace x86 {
+
+/* Selectors of the kernel GDT. Code and data keep the selectors the entry
+ * code switched to the long mode with. */
+constexpr uint16_t kernel_code_selector = 0x08;
+constexpr uint16_t kernel_data_selector = 0x10;
+constexpr uint16_t tss_selector = 0x18;
+
+/* Slots of the interrupt stack table. Exceptions that can hit while the
+ * stack is unusable get a known good stack of their own. */
+enum class IST : uint8_t {
+	None 		= 0,
+	NMI 		= 1,
+	DoubleFault 	= 2,
+	MachineCheck 	= 3,
+};
+
+constexpr size_t ist_stack_size = 0x1000;
+
+/* 64bit task state segment, only used for its stack pointers. */
+struct TSS {
+	uint32_t reserved0;
+	uint64_t rsp[3];
+	uint64_t reserved1;
+	uint64_t ist[7];
+	uint64_t reserved2;
+	uint16_t reserved3;
+	uint16_t iomap_base;
+} __attribute__((packed));
+
+/* Load the kernel GDT with a TSS holding the interrupt stacks, and reload
+ * the segment registers from it. */
+void setup_segmentation();
+
+}
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef _x86__SYSTEM_H__
 #define _x86__SYSTEM_H__
 
+#include <stdint.h>
+#include <x86/cr.h>
+
 namespace x86 {
 
 inline void halt()
@@ -8,6 +11,75 @@ inline void halt()
 	asm volatile ("hlt");
 }
 
+/* Interrupt enable flag in (E/R)FLAGS. */
+constexpr unsigned long interrupt_flag = 1 << 9;
+
+/* Disable interrupts and return the flags they were enabled in. */
+inline unsigned long irq_save()
+{
+	unsigned long flags;
+	asm volatile (
+		"pushf 		\n"
+		"pop %0 	\n"
+		"cli 		\n"
+		: "=r"(flags) :: "memory"
+	);
+	return flags;
+}
+
+inline void irq_enable()
+{
+	asm volatile ("sti" ::: "memory");
+}
+
+/* Enable interrupts again if they were in the flags irq_save returned. */
+inline void irq_restore(unsigned long flags)
+{
+	if (flags & interrupt_flag)
+		asm volatile ("sti" ::: "memory");
+}
+
+/* Allow SSE instructions, they raise #UD until the OS says it saves
+ * their state. Every 64bit capable CPU has SSE2. */
+inline void enable_sse()
+{
+	auto cr0_val = read_cr0_flags();
+	cr0_val &= ~CR0_Flags::EM;
+	cr0_val |= CR0_Flags::MP;
+	write_cr0_flags(cr0_val);
+
+	write_cr4_flags(read_cr4_flags() | CR4_Flags::OSFXSR | CR4_Flags::OSXMMEXCPT);
+}
+
+/* Extended control register 0 flags, the state components enabled. */
+enum class XCR0_Flags : uint64_t {
+	X87 = 1 << 0,
+	SSE = 1 << 1,
+	AVX = 1 << 2,
+};
+KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(XCR0_Flags);
+
+inline XCR0_Flags read_xcr0_flags()
+{
+	uint32_t eax, edx;
+	asm volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return kstd::to_enum<XCR0_Flags>((uint64_t(edx) << 32) | eax);
+}
+
+inline void write_xcr0_flags(XCR0_Flags flags)
+{
+	const auto val = static_cast<uint64_t>(flags);
+	asm volatile ("xsetbv" :: "a"(uint32_t(val)), "d"(uint32_t(val >> 32)), "c"(0));
+}
+
+/* Allow AVX instructions. Needs SSE enabled and a CPU with XSAVE and AVX. */
+inline void enable_avx()
+{
+	write_cr4_flags(read_cr4_flags() | CR4_Flags::OSXSAVE);
+	write_xcr0_flags(read_xcr0_flags()
+			| XCR0_Flags::X87 | XCR0_Flags::SSE | XCR0_Flags::AVX);
+}
+
 }
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef _x86_TIME__APIC_TIMER_H__
+#define _x86_TIME__APIC_TIMER_H__
+
+#include <stdint.h>
+
+#include <x86/interrupts/idt.h>
+
+namespace x86 {
+
+/* Setup the local APIC timer of the current CPU for one-shot deadlines given
+ * as TSC values, calling handler when they pass. The TSC-deadline mode is used
+ * if the CPU has it, the one-shot mode with its count calibrated against the
+ * TSC otherwise. Needs the local APIC enabled. */
+void setup_apic_timer(bool tsc_deadline, InterruptHandler handler);
+
+/* Raise the timer interrupt once the TSC reaches deadline, a deadline already
+ * passed fires right away. In the one-shot mode the count is limited to 32
+ * bits, deadlines beyond it fire early. */
+void set_apic_timer_deadline(uint64_t deadline);
+
+void stop_apic_timer();
+
+}
+
+#endif
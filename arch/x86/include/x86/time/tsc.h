@@ -0,0 +1,27 @@
+#ifndef _x86_TIME__TSC_H__
+#define _x86_TIME__TSC_H__
+
+#include <stdint.h>
+
+#include <compiler_attributes.h>
+
+namespace x86 {
+
+__FORCE_INLINE uint64_t read_tsc()
+{
+	uint32_t low, high;
+	asm volatile ("rdtsc" : "=a"(low), "=d"(high));
+	return (uint64_t(high) << 32) | low;
+}
+
+/* Find out the TSC frequency in Hz from CPUID leaf 0x15 or 0x16, measuring
+ * it against the PIT if neither has it. Returns 0 if all of them fail. */
+uint64_t get_tsc_frequency();
+
+/* Whether the TSC runs at the same rate in all P-, C- and T-states, only then
+ * it's usable as a clock. */
+bool is_tsc_invariant();
+
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _x86_UTILS_SERIAL__OSTREAM_H__
+#define _x86_UTILS_SERIAL__OSTREAM_H__
+
+#include <x86/utils/serial/uart.h>
+#include <kstd/io.h>
+
+namespace x86::utils {
+
+class Serial_OStream final : public kstd::OStream {
+public:
+	void putc(const char c) override;
+	void puts(const char *str) override;
+	void write(const char *str, size_t len) override;
+
+	UART16550& get_uart();
+
+private:
+	UART16550 uart;
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef _x86_UTILS_SERIAL__UART_H__
+#define _x86_UTILS_SERIAL__UART_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace x86::utils {
+
+/* 16550 compatible UART. Characters are queued in a ring and moved into
+ * the transmit FIFO a whole FIFO at a time, never a byte per status poll.
+ * Transmitting is polled: writers drain the queue themselves before
+ * returning, with interrupts only disabled while the queue is touched. */
+class UART16550 {
+public:
+	static constexpr uint16_t com1_port = 0x3F8;
+	static constexpr unsigned int max_baud_rate = 115200;
+
+	explicit UART16550(uint16_t port = com1_port, unsigned int baud_rate = max_baud_rate);
+
+	/* Whether a UART answered at the port. Writing to a missing one does
+	 * nothing. */
+	bool is_present() const;
+
+	/* Put a character, line feeds are sent as CR LF. */
+	void putc(const char c);
+	/* Put a string with length. */
+	void write(const char *str, size_t len);
+
+private:
+	size_t get_tx_room() const;
+	void enqueue(char c);
+	/* Fill the FIFO from the queue if the transmitter is empty. */
+	void fill_fifo();
+	void wait_for_tx_empty();
+
+	static constexpr size_t tx_ring_size = 1024;
+
+	uint16_t port;
+	bool present = false;
+	size_t fifo_size = 1; /* 16 if the FIFO could be enabled. */
+	size_t tx_head = 0; /* Where the next character is queued. */
+	size_t tx_tail = 0; /* Next character to send. */
+	char tx_ring[tx_ring_size];
+};
+
+inline bool UART16550::is_present() const
+{
+	return present;
+}
+
+}
+
+#endif
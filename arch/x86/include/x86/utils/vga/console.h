@@ -2,6 +2,7 @@
 #define _x86_UTILS_VGA__CONSOLE_H__
 
 #include <stddef.h>
+#include <stdint.h>
 
 namespace x86::utils {
 
@@ -30,7 +31,9 @@ constexpr char vga_make_color(char fg, char bg)
 	return fg | (bg << 4);
 }
 
-/* VGA Text based console. */
+/* VGA Text based console. Characters go to a copy of the screen in RAM
+ * and only the lines that changed are copied to the video memory, once per
+ * call. The copy is shared by all the consoles, like the screen is. */
 class VGAConsole {
 private:
 	/* Console typing mode. */
@@ -62,7 +65,13 @@ public:
 	static constexpr unsigned int tab_stop = 8;
 
 private:
+	/* Put a character without flushing. */
+	void put_char(const char c);
 	void put_normal_char(char c);
+	/* Put characters that are all printable. */
+	void put_normal_run(const char *str, size_t len);
+	/* Get the length of the run of printable characters str starts with. */
+	static size_t get_printable_len(const char *str, size_t len);
 	void put_cr();
 	void put_lf();
 	void put_tb();
@@ -75,6 +84,8 @@ private:
 
 	void move_screen(long lines);
 	void clear_screen();
+	/* Copy the changed lines to the video memory. */
+	void flush();
 
 	void reset();
 
@@ -83,6 +94,9 @@ private:
 
 	void set_char(char c);
 
+	/* Get a line of the screen copy. */
+	static char *get_row(long y);
+
 	static bool is_esc_exiting_char(char c);
 	static EscType get_esc_exiting_type(char c);
 
@@ -106,6 +120,19 @@ private:
 	static constexpr long bytes_per_cell = 2;
 	/* Total number of bytes in buffer including characters and colors. */
 	static constexpr long tot_nr_bytes = tot_nr_cells * bytes_per_cell;
+	/* Number of bytes per line. */
+	static constexpr long bytes_per_row = nr_cols * bytes_per_cell;
+
+	/* Copy of the screen, its lines are a ring so scrolling only moves the
+	 * first line. */
+	struct Screen {
+		char rows[nr_rows][bytes_per_row];
+		long first_row;
+		uint32_t dirty_rows; /* Bit y set if line y differs from the screen. */
+		bool loaded; /* Whether it holds what's on the screen. */
+	};
+	static_assert(nr_rows <= 32, "a bit per line must fit in dirty_rows");
+	static Screen screen;
 
 	long curr_x = 0; /* Current x compontent of the cursor. */
 	long curr_y = 0; /* Current y compontent of the cursor. */
@@ -6,7 +6,7 @@
 
 namespace x86::utils {
 
-class VGA_OStream : public kstd::OStream {
+class VGA_OStream final : public kstd::OStream {
 public:
 	void putc(const char c) override;
 	void puts(const char *str) override;
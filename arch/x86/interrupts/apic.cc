@@ -0,0 +1,142 @@
+#include <x86/interrupts/apic.h>
+#include <x86/interrupts/idt.h>
+#include <x86/msr.h>
+
+
+namespace x86 {
+
+namespace {
+
+constexpr uint64_t apic_base_x2apic = 1 << 10;
+constexpr uint64_t apic_base_enable = 1 << 11;
+constexpr uint64_t apic_base_addr_mask = 0x000FFFFFFFFFF000;
+
+constexpr uint32_t svr_apic_enable = 1 << 8;
+constexpr uint32_t icr_delivery_pending = 1 << 12; /* xAPIC only */
+constexpr uint32_t icr_level_assert = 1 << 14;
+
+/* Number of the last LVT entry, perfmon and thermal ones may be missing. */
+constexpr unsigned int max_lvt_perfmon = 4;
+constexpr unsigned int max_lvt_thermal = 5;
+
+volatile uint32_t *xapic_regs = nullptr;
+bool x2apic = false;
+
+volatile uint32_t& xapic_reg(APIC_Reg reg)
+{
+	// registers are 16 bytes apart
+	return xapic_regs[static_cast<unsigned int>(reg) * 4];
+}
+
+MSR x2apic_msr(APIC_Reg reg)
+{
+	return static_cast<MSR>(static_cast<uint32_t>(MSR::x2APIC_Base)
+			+ static_cast<uint32_t>(reg));
+}
+
+void handle_apic_error(unsigned int)
+{
+	// the error status is latched by writing it
+	write_apic(APIC_Reg::ErrorStatus, 0);
+	apic_eoi();
+}
+
+}
+
+PhysAddr get_apic_phys_addr()
+{
+	return read_msr(MSR::APIC_Base) & apic_base_addr_mask;
+}
+
+void setup_apic(volatile uint32_t *regs)
+{
+	// the x2APIC mode can only be entered from the enabled xAPIC mode
+	uint64_t apic_base = read_msr(MSR::APIC_Base) | apic_base_enable;
+	write_msr(MSR::APIC_Base, apic_base);
+	if (regs) {
+		xapic_regs = regs;
+	} else {
+		write_msr(MSR::APIC_Base, apic_base | apic_base_x2apic);
+		x2apic = true;
+	}
+
+	const unsigned int max_lvt = read_apic(APIC_Reg::Version) >> 16 & 0xFF;
+	set_apic_lvt(APIC_Reg::LVT_Timer, 0);
+	if (max_lvt >= max_lvt_thermal)
+		set_apic_lvt(APIC_Reg::LVT_Thermal, 0);
+	if (max_lvt >= max_lvt_perfmon)
+		set_apic_lvt(APIC_Reg::LVT_PerfMon, 0);
+	// the legacy PIC is masked, the firmware wires NMIs to LINT1
+	set_apic_lvt(APIC_Reg::LVT_LINT0, 0);
+	set_apic_lvt(APIC_Reg::LVT_LINT1, static_cast<unsigned int>(Exception::NMI),
+			APIC_Delivery::NMI);
+
+	set_interrupt_handler(apic_error_vector, handle_apic_error);
+	set_apic_lvt(APIC_Reg::LVT_Error, apic_error_vector);
+	write_apic(APIC_Reg::ErrorStatus, 0);
+	write_apic(APIC_Reg::ErrorStatus, 0);
+
+	write_apic(APIC_Reg::TaskPriority, 0);
+	write_apic(APIC_Reg::SpuriousVector, svr_apic_enable | apic_spurious_vector);
+}
+
+bool is_x2apic_enabled()
+{
+	return x2apic;
+}
+
+uint32_t read_apic(APIC_Reg reg)
+{
+	if (x2apic)
+		return read_msr(x2apic_msr(reg));
+	return xapic_reg(reg);
+}
+
+void write_apic(APIC_Reg reg, uint32_t val)
+{
+	if (x2apic)
+		write_msr(x2apic_msr(reg), val);
+	else
+		xapic_reg(reg) = val;
+}
+
+void apic_eoi()
+{
+	write_apic(APIC_Reg::EOI, 0);
+}
+
+uint32_t get_apic_id()
+{
+	const uint32_t id = read_apic(APIC_Reg::ID);
+	return x2apic ? id : id >> 24;
+}
+
+void set_apic_lvt(APIC_Reg lvt, unsigned int vector, APIC_Delivery delivery)
+{
+	if (vector)
+		write_apic(lvt, vector | static_cast<uint32_t>(delivery));
+	else
+		write_apic(lvt, apic_lvt_masked);
+}
+
+void send_ipi(IPI_Dest dest, uint32_t apic_id, unsigned int vector, APIC_Delivery delivery)
+{
+	const uint32_t command = static_cast<uint32_t>(dest) | static_cast<uint32_t>(delivery)
+				| icr_level_assert | vector;
+
+	if (x2apic) {
+		// writing the MSR doesn't wait for earlier stores, the target
+		// has to see what it's interrupted for
+		asm volatile ("mfence; lfence" ::: "memory");
+		write_msr(x2apic_msr(APIC_Reg::InterruptCommand),
+				(uint64_t(apic_id) << 32) | command);
+		return;
+	}
+
+	while (xapic_reg(APIC_Reg::InterruptCommand) & icr_delivery_pending)
+		asm volatile ("pause");
+	xapic_reg(APIC_Reg::InterruptCommandHigh) = apic_id << 24;
+	xapic_reg(APIC_Reg::InterruptCommand) = command;
+}
+
+}
@@ -0,0 +1,159 @@
+#include <x86/interrupts/idt.h>
+#include <x86/segmentation.h>
+#include <x86/system.h>
+#include <x86/kout.h>
+
+#include <kstd/format.h>
+
+
+namespace x86 {
+
+namespace {
+
+/* 64bit interrupt gate descriptor. */
+struct IDT_Entry {
+	uint16_t offset_low;
+	uint16_t selector;
+	uint8_t ist;
+	uint8_t type_attr;
+	uint16_t offset_mid;
+	uint32_t offset_high;
+	uint32_t reserved;
+} __attribute__((packed));
+
+struct IDT_Ptr {
+	uint16_t size;
+	uint64_t addr;
+} __attribute__((packed));
+
+/* Present interrupt gate, interrupts stay disabled in the handlers. */
+constexpr uint8_t interrupt_gate = 0x8E;
+
+/* Size the stubs are aligned to in stubs.S. */
+constexpr unsigned int stub_size = 16;
+
+IDT_Entry idt[nr_vectors];
+
+ExceptionHandler exception_handlers[first_interrupt_vector];
+PanicHook panic_hook = nullptr;
+
+const char *const exception_names[first_interrupt_vector] = {
+	"#DE", "#DB", "NMI", "#BP", "#OF", "#BR", "#UD", "#NM",
+	"#DF", "", "#TS", "#NP", "#SS", "#GP", "#PF", "",
+	"#MF", "#AC", "#MC", "#XM", "#VE", "#CP",
+};
+
+void set_gate(unsigned int vector, uintptr_t handler, IST ist)
+{
+	idt[vector] = {
+		.offset_low = uint16_t(handler),
+		.selector = kernel_code_selector,
+		.ist = static_cast<uint8_t>(ist),
+		.type_attr = interrupt_gate,
+		.offset_mid = uint16_t(handler >> 16),
+		.offset_high = uint32_t(handler >> 32),
+		.reserved = 0,
+	};
+}
+
+IST get_ist(unsigned int vector)
+{
+	switch (static_cast<Exception>(vector)) {
+	case Exception::NMI:
+		return IST::NMI;
+	case Exception::DoubleFault:
+		return IST::DoubleFault;
+	case Exception::MachineCheck:
+		return IST::MachineCheck;
+	default:
+		return IST::None;
+	}
+}
+
+[[noreturn]] void unhandled_exception(const InterruptFrame& frame)
+{
+	// cleared first, an exception in the hook is reported without it
+	const PanicHook hook = panic_hook;
+	panic_hook = nullptr;
+	if (hook)
+		hook();
+
+	const char *name = exception_names[frame.vector];
+	kstd::print(kout, "\nUnhandled exception {} {} at {:#018x}, error code {:#x}\n",
+			frame.vector, name ? name : "", frame.rip, frame.error_code);
+	kstd::print(kout, "rax={:016x} rbx={:016x} rcx={:016x} rdx={:016x}\n",
+			frame.rax, frame.rbx, frame.rcx, frame.rdx);
+	kstd::print(kout, "rsi={:016x} rdi={:016x} rbp={:016x} rsp={:016x}\n",
+			frame.rsi, frame.rdi, frame.rbp, frame.rsp);
+	kstd::print(kout, "r8 ={:016x} r9 ={:016x} r10={:016x} r11={:016x}\n",
+			frame.r8, frame.r9, frame.r10, frame.r11);
+	kstd::print(kout, "r12={:016x} r13={:016x} r14={:016x} r15={:016x}\n",
+			frame.r12, frame.r13, frame.r14, frame.r15);
+	kstd::print(kout, "rflags={:016x} cs={:#x} ss={:#x} cr2={:016x}\n",
+			frame.rflags, frame.cs, frame.ss, read_cr2());
+
+	while (true)
+		halt();
+}
+
+void ignore_interrupt(unsigned int)
+{
+}
+
+}
+
+extern "C" {
+
+/* Used by the stubs, see stubs.S. */
+extern const char x86_interrupt_stubs[];
+InterruptHandler x86_interrupt_handlers[nr_vectors];
+uint8_t x86_interrupt_save_ymm;
+
+void x86_handle_exception(InterruptFrame *frame)
+{
+	const ExceptionHandler handler = exception_handlers[frame->vector];
+	if (!handler)
+		unhandled_exception(*frame);
+	handler(frame);
+}
+
+}
+
+void setup_interrupts()
+{
+	setup_segmentation();
+
+	// the upper halves of the AVX registers have to be saved as well
+	x86_interrupt_save_ymm = kstd::test_flag(read_cr4_flags(), CR4_Flags::OSXSAVE)
+				&& kstd::test_flag(read_xcr0_flags(), XCR0_Flags::AVX);
+
+	const auto stubs = reinterpret_cast<uintptr_t>(x86_interrupt_stubs);
+	for (unsigned int vector = 0; vector < nr_vectors; ++vector) {
+		set_gate(vector, stubs + vector * stub_size, get_ist(vector));
+		if (vector >= first_interrupt_vector)
+			x86_interrupt_handlers[vector] = ignore_interrupt;
+	}
+
+	const IDT_Ptr idt_ptr {
+		.size = sizeof(idt) - 1,
+		.addr = reinterpret_cast<uint64_t>(idt),
+	};
+	asm volatile ("lidt %0" :: "m"(idt_ptr));
+}
+
+void set_exception_handler(Exception exception, ExceptionHandler handler)
+{
+	exception_handlers[static_cast<unsigned int>(exception)] = handler;
+}
+
+void set_interrupt_handler(unsigned int vector, InterruptHandler handler)
+{
+	x86_interrupt_handlers[vector] = handler ? handler : ignore_interrupt;
+}
+
+void set_panic_hook(PanicHook hook)
+{
+	panic_hook = hook;
+}
+
+}
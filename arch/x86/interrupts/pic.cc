@@ -0,0 +1,51 @@
+#include <x86/interrupts/pic.h>
+#include <x86/interrupts/idt.h>
+#include <x86/port_io.h>
+
+
+namespace x86 {
+
+namespace {
+
+constexpr uint16_t master_command = 0x20;
+constexpr uint16_t master_data = 0x21;
+constexpr uint16_t slave_command = 0xA0;
+constexpr uint16_t slave_data = 0xA1;
+
+constexpr uint8_t icw1_init = 0x11; /* initialize, ICW4 follows */
+constexpr uint8_t icw4_8086 = 0x01;
+constexpr uint8_t slave_line = 2; /* line of the master the slave is on */
+
+/* Give the PIC time to take the previous command. */
+void io_wait()
+{
+	outb(0x80, 0);
+}
+
+}
+
+void disable_legacy_pic()
+{
+	outb(master_command, icw1_init);
+	io_wait();
+	outb(slave_command, icw1_init);
+	io_wait();
+	outb(master_data, legacy_pic_vector);
+	io_wait();
+	outb(slave_data, legacy_pic_vector + 8);
+	io_wait();
+	outb(master_data, 1 << slave_line);
+	io_wait();
+	outb(slave_data, slave_line);
+	io_wait();
+	outb(master_data, icw4_8086);
+	io_wait();
+	outb(slave_data, icw4_8086);
+	io_wait();
+
+	// mask all lines
+	outb(master_data, 0xFF);
+	outb(slave_data, 0xFF);
+}
+
+}
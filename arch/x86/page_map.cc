@@ -6,19 +6,9 @@
 #include <kstd/overflow.h>
 #include <kstd/either.h>
 #include <kstd/algorithm.h>
-#include <kstd/new.h>
 
 namespace x86 {
 
-enum class LocalErr {
-	None = 0,
-	Overflow,
-	NoFreeMemory,
-};
-
-template<int pml>
-static kstd::Either<PhysAddr, LocalErr> create_page_table(kstd::MemoryRange& free_mem);
-
 enum class SetEntryFlagsMode {
 	Page, PageTable
 };
@@ -26,13 +16,27 @@ enum class SetEntryFlagsMode {
 /* Sets entry flags for page table entry. If the 'mode' template argument is Page
  * will set the flags for lowest level page table entry.
  * Otherwise will do it for an entry that maps another page table. */
-template<int pml, SetEntryFlagsMode mode>
+template<SetEntryFlagsMode mode, int pml>
 static void set_entry_flags(PageTableEntry_<pml>& entry, PageEntryFlags flags);
 
+/* Get the flags of an entry mapping a page. */
+template<int pml>
+static PageEntryFlags get_entry_flags(const PageTableEntry_<pml>& entry);
+
+/* Make the entry map a page at page_addr with the given flags. */
+template<int pml>
+static void set_page_entry(PageTableEntry_<pml>& entry, PhysAddr page_addr,
+		PageEntryFlags flags);
+
+/* Make the entry link the page table at pt_addr with the least permissive
+ * flags, they are relaxed later by the pages mapped through it. */
+template<int pml>
+static void set_page_table_entry(PageTableEntry_<pml>& entry, PhysAddr pt_addr);
+
 static bool check_alignment(LineAddr linaddr_beg, PhysAddr phyaddr_beg, PageSize ps);
 
 template<int pml> PageMapErr PageTable_<pml>::map_memory(
-		PageMappingInfo &info, kstd::MemoryRange& free_mem)
+		PageMappingInfo &info, PageTableAllocator& allocator)
 {
 	auto e = check_overflow(info.linaddr_beg, info.phyaddr_beg, info.phyaddr_end);
 	if (e != PageMapErr::None)
@@ -43,12 +47,20 @@ template<int pml> PageMapErr PageTable_<pml>::map_memory(
 		// and which is not larger than mapping size (phyaddr_end - phyaddr_beg)
 		const auto maybe_page_size =
 			find_max_page_size(info.linaddr_beg, info.phyaddr_beg,
-					info.phyaddr_end - info.phyaddr_beg);
+					info.phyaddr_end - info.phyaddr_beg,
+					info.max_page_size);
 		if (!maybe_page_size.has_value())
 			return PageMapErr::AddressMismatch;
 
 		info.page_size = *maybe_page_size;
-		auto e = map_pages__no_chk(info, free_mem);
+
+		// don't let the pages of the chosen size run past the end of the memory
+		const PhysAddr phyaddr_end = info.phyaddr_end;
+		info.phyaddr_end = info.phyaddr_beg + kstd::align_floored(
+				phyaddr_end - info.phyaddr_beg,
+				get_page_size_shift(info.page_size));
+		auto e = map_pages__no_chk(info, allocator);
+		info.phyaddr_end = phyaddr_end;
 		if (e != PageMapErr::None)
 			return e;
 	}
@@ -57,7 +69,7 @@ template<int pml> PageMapErr PageTable_<pml>::map_memory(
 }
 
 template<int pml> PageMapErr PageTable_<pml>::map_pages(
-		PageMappingInfo& info, kstd::MemoryRange& free_mem)
+		PageMappingInfo& info, PageTableAllocator& allocator)
 {
 	if (!check_alignment(info.linaddr_beg, info.phyaddr_beg, info.page_size))
 		return PageMapErr::UnalignedAddress;
@@ -68,26 +80,26 @@ template<int pml> PageMapErr PageTable_<pml>::map_pages(
 	if (e != PageMapErr::None)
 		return e;
 
-	return map_pages__no_chk(info, free_mem);
+	return map_pages__no_chk(info, allocator);
 }
 
 template<int pml> PageMapErr PageTable_<pml>::map_pages__no_chk(
-		PageMappingInfo& info, kstd::MemoryRange& free_mem)
+		PageMappingInfo& info, PageTableAllocator& allocator)
 {
 	switch (info.page_size) {
 	case PageSize::_4Kb:
-		return map_pages__const_ps<PageSize::_4Kb>(info, free_mem);
+		return map_pages__const_ps<PageSize::_4Kb>(info, allocator);
 #if CONFIG_x86_PAGE_MAP_LEVEL >= x86_PAGE_MAP_LEVEL_3_PAE
 	case PageSize::_2Mb:
-		return map_pages__const_ps<PageSize::_2Mb>(info, free_mem);
+		return map_pages__const_ps<PageSize::_2Mb>(info, allocator);
 #endif
 #if CONFIG_x86_PAGE_MAP_LEVEL == x86_PAGE_MAP_LEVEL_2
 	case PageSize::_4Mb:
-		return map_pages__const_ps<PageSize::_4Mb>(info, free_mem);
+		return map_pages__const_ps<PageSize::_4Mb>(info, allocator);
 #endif
 #if CONFIG_x86_PAGE_MAP_LEVEL >= x86_PAGE_MAP_LEVEL_4
 	case PageSize::_1Gb:
-		return map_pages__const_ps<PageSize::_1Gb>(info, free_mem);
+		return map_pages__const_ps<PageSize::_1Gb>(info, allocator);
 #endif
 	};
 
@@ -96,7 +108,7 @@ template<int pml> PageMapErr PageTable_<pml>::map_pages__no_chk(
 
 template<int pml> template<PageSize page_size>
 __FORCE_INLINE PageMapErr PageTable_<pml>::map_pages__const_ps(
-		PageMappingInfo& info, kstd::MemoryRange& free_mem)
+		PageMappingInfo& info, PageTableAllocator& allocator)
 {
 	using kstd::test_flag;
 
@@ -158,7 +170,7 @@ __FORCE_INLINE PageMapErr PageTable_<pml>::map_pages__const_ps(
 
 			// if there's already a page table mapped by the given entry, get it,
 			// otherwise create and get it
-			auto next_pt_or_err = get_or_map_page_table(entry, free_mem);
+			auto next_pt_or_err = get_or_map_page_table(entry, allocator);
 			if (auto *e = kstd::try_get<PageMapErr>(next_pt_or_err))
 				return *e;
 
@@ -170,7 +182,7 @@ __FORCE_INLINE PageMapErr PageTable_<pml>::map_pages__const_ps(
 			 * be inlined here. There are no other places where this method of
 			 * (pml < max_page_map_level) page table class could be called. */
 			auto e = next_pt->template
-				map_pages__const_ps<page_size>(info, free_mem);
+				map_pages__const_ps<page_size>(info, allocator);
 			if (e != PageMapErr::None)
 				return e;
 
@@ -181,6 +193,169 @@ __FORCE_INLINE PageMapErr PageTable_<pml>::map_pages__const_ps(
 	return PageMapErr::None;
 }
 
+template<int pml> PageMapErr PageTable_<pml>::unmap_range(
+		LineAddr linaddr_beg, LineAddr linaddr_end, PageTableAllocator& allocator,
+		TLBFlushBatch& tlb_batch)
+{
+	auto e = check_range(linaddr_beg, linaddr_end);
+	if (e != PageMapErr::None)
+		return e;
+
+	return unmap_range__no_chk(linaddr_beg, linaddr_end, allocator, tlb_batch);
+}
+
+template<int pml> PageMapErr PageTable_<pml>::protect_range(
+		LineAddr linaddr_beg, LineAddr linaddr_end, PageEntryFlags flags,
+		PageTableAllocator& allocator, TLBFlushBatch& tlb_batch,
+		PageSize max_page_size)
+{
+	auto e = check_range(linaddr_beg, linaddr_end);
+	if (e != PageMapErr::None)
+		return e;
+
+	return protect_range__no_chk(linaddr_beg, linaddr_end, flags, allocator,
+			tlb_batch, max_page_size);
+}
+
+template<int pml> kstd::Maybe<PageTranslation> PageTable_<pml>::translate(
+		LineAddr linaddr, const PageTableAllocator& allocator) const
+{
+	const auto& entry = entries[get_pte_idx<pml>(linaddr)];
+	if (!entry.is_present())
+		return {};
+
+	if constexpr (pml <= constants::max_pml_having_ps_bit) {
+		if (entry.maps_page()) {
+			return PageTranslation {
+				.phyaddr = entry.get_page_addr()
+					+ (linaddr & (controlled_mem_per_entry - 1)),
+				.page_size = page_sizes[pml - 1],
+				.flags = get_entry_flags(entry),
+			};
+		}
+	}
+
+	if constexpr (pml > 1)
+		return get_page_table(entry, allocator)->translate(linaddr, allocator);
+	else
+		return {};
+}
+
+template<int pml>
+__FORCE_INLINE PageMapErr PageTable_<pml>::unmap_range__no_chk(
+		LineAddr& linaddr_beg, LineAddr linaddr_end, PageTableAllocator& allocator,
+		TLBFlushBatch& tlb_batch)
+{
+	constexpr auto controlled_bits = PageTableEntry_<pml>::controlled_bits;
+
+	auto pte_idx = get_pte_idx<pml>(linaddr_beg);
+
+	while (linaddr_beg < linaddr_end && pte_idx < nr_entries) {
+		auto& entry = entries[pte_idx];
+		const LineAddr entry_beg = kstd::align_floored(linaddr_beg, controlled_bits);
+		const LineAddr entry_end = entry_beg + controlled_mem_per_entry;
+		const bool whole_entry = linaddr_beg == entry_beg && entry_end <= linaddr_end;
+
+		if (entry.is_present() && entry.maps_page() && whole_entry) {
+			tlb_batch.add_page(entry_beg, entry.is_global());
+			entry.clear();
+		} else if (entry.is_present()) {
+			if constexpr (pml > 1) {
+				// only a part of the large page is unmapped
+				if constexpr (pml <= constants::max_pml_having_ps_bit) {
+					if (entry.maps_page()) {
+						auto e = split_page(entry, allocator);
+						if (e != PageMapErr::None)
+							return e;
+					}
+				}
+
+				const PhysAddr next_pt_addr = entry.get_page_table_addr();
+				auto *next_pt = get_page_table(entry, allocator);
+				// "compile-time resolved recursive" call, see map_pages__const_ps
+				auto e = next_pt->unmap_range__no_chk(linaddr_beg, linaddr_end,
+						allocator, tlb_batch);
+				if (next_pt->is_empty()) {
+					entry.clear();
+					tlb_batch.add_page_table(entry_beg, false,
+							next_pt_addr, allocator);
+				}
+				if (e != PageMapErr::None)
+					return e;
+
+				// the lower level page table has advanced linaddr_beg
+				++pte_idx;
+				continue;
+			}
+		}
+
+		linaddr_beg = kstd::min(entry_end, linaddr_end);
+		++pte_idx;
+	}
+
+	return PageMapErr::None;
+}
+
+template<int pml>
+__FORCE_INLINE PageMapErr PageTable_<pml>::protect_range__no_chk(
+		LineAddr& linaddr_beg, LineAddr linaddr_end, PageEntryFlags flags,
+		PageTableAllocator& allocator, TLBFlushBatch& tlb_batch,
+		PageSize max_page_size)
+{
+	constexpr auto controlled_bits = PageTableEntry_<pml>::controlled_bits;
+
+	auto pte_idx = get_pte_idx<pml>(linaddr_beg);
+
+	while (linaddr_beg < linaddr_end && pte_idx < nr_entries) {
+		auto& entry = entries[pte_idx];
+		const LineAddr entry_beg = kstd::align_floored(linaddr_beg, controlled_bits);
+		const LineAddr entry_end = entry_beg + controlled_mem_per_entry;
+		const bool whole_entry = linaddr_beg == entry_beg && entry_end <= linaddr_end;
+
+		if (entry.is_present() && entry.maps_page() && whole_entry) {
+			if constexpr (pml <= constants::max_pml_having_ps_bit) {
+				if (get_entry_flags(entry) != flags) {
+					tlb_batch.add_page(entry_beg, entry.is_global());
+					set_page_entry(entry, entry.get_page_addr(), flags);
+				}
+			}
+		} else if (entry.is_present()) {
+			if constexpr (pml > 1) {
+				// only a part of the large page is protected
+				if constexpr (pml <= constants::max_pml_having_ps_bit) {
+					if (entry.maps_page()) {
+						auto e = split_page(entry, allocator);
+						if (e != PageMapErr::None)
+							return e;
+					}
+				}
+
+				auto *next_pt = get_page_table(entry, allocator);
+				// "compile-time resolved recursive" call, see map_pages__const_ps
+				auto e = next_pt->protect_range__no_chk(linaddr_beg, linaddr_end,
+						flags, allocator, tlb_batch, max_page_size);
+				set_entry_flags<SetEntryFlagsMode::PageTable>(entry, flags);
+				if (e != PageMapErr::None)
+					return e;
+
+				if constexpr (pml <= constants::max_pml_having_ps_bit) {
+					if ((unsigned)page_sizes[pml - 1] <= (unsigned)max_page_size)
+						try_merge_page_table(entry, entry_beg, allocator, tlb_batch);
+				}
+
+				// the lower level page table has advanced linaddr_beg
+				++pte_idx;
+				continue;
+			}
+		}
+
+		linaddr_beg = kstd::min(entry_end, linaddr_end);
+		++pte_idx;
+	}
+
+	return PageMapErr::None;
+}
+
 template<int pml> PageMapErr
 PageTable_<pml>::check_overflow(LineAddr linaddr_beg, PhysAddr phyaddr_beg, PhysAddr phyaddr_end)
 {
@@ -196,61 +371,129 @@ PageTable_<pml>::check_overflow(LineAddr linaddr_beg, PhysAddr phyaddr_beg, Phys
 	return PageMapErr::None;
 }
 
+template<int pml> PageMapErr
+PageTable_<pml>::check_range(LineAddr linaddr_beg, LineAddr linaddr_end)
+{
+	constexpr auto min_page_size = get_page_size_bytes(page_sizes[0]);
+
+	if ((linaddr_beg & (min_page_size - 1)) || (linaddr_end & (min_page_size - 1)))
+		return PageMapErr::UnalignedAddress;
+	if (linaddr_beg > linaddr_end || linaddr_end > controlled_mem)
+		return PageMapErr::LinearAddressOverflow;
+
+	return PageMapErr::None;
+}
+
 template<int pml> kstd::Either<PageTable_<pml - 1> *, PageMapErr>
-PageTable_<pml>::get_or_map_page_table(PageTableEntry_<pml>& entry, kstd::MemoryRange& free_mem)
+PageTable_<pml>::get_or_map_page_table(PageTableEntry_<pml>& entry, PageTableAllocator& allocator)
 {
 	static_assert(pml > 1, "Can't have pml == 1 here.");
-	PhysAddr next_pt_addr {};
 
 	if (entry.is_present()) {
 		if (entry.maps_page())
 			return PageMapErr::ExistingPageMap;
 		// if reached here then the entry does map a page table
-		next_pt_addr = entry.get_page_table_addr();
 	} else {
 		// no page table pointed by the entry, creating
-		auto maybe_pt_ptr = create_page_table<pml - 1>(free_mem);
-
-		auto *p_err = kstd::try_get<LocalErr>(maybe_pt_ptr);
-		if (p_err && *p_err == LocalErr::NoFreeMemory)
+		const PhysAddr next_pt_addr = allocator.alloc();
+		if (!next_pt_addr)
 			return PageMapErr::NoFreeMem;
 
-		next_pt_addr = kstd::get<PhysAddr>(maybe_pt_ptr);
-		entry.map_page_table((PhysAddr)next_pt_addr);
-		entry.set_present(true);
-		entry.set_write_allowed(false);
-		entry.set_supervisor(true);
-		entry.set_execute_disabled(true);
+		set_page_table_entry(entry, next_pt_addr);
 	}
 
-	return reinterpret_cast<PageTable_<pml - 1> *>(next_pt_addr);
+	return get_page_table(entry, allocator);
 }
 
-/* Define the page table class. */
-template class PageTable_<max_page_map_level>;
-
+template<int pml> PageTable_<pml - 1> *PageTable_<pml>::get_page_table(
+		const PageTableEntry_<pml>& entry, const PageTableAllocator& allocator)
+{
+	static_assert(pml > 1, "Can't have pml == 1 here.");
+	return static_cast<PageTable_<pml - 1> *>(
+			allocator.to_virt(entry.get_page_table_addr()));
+}
 
-template<int pml>
-static kstd::Either<PhysAddr, LocalErr> create_page_table(kstd::MemoryRange& free_mem)
+template<int pml> PageMapErr PageTable_<pml>::split_page(
+		PageTableEntry_<pml>& entry, PageTableAllocator& allocator)
 {
-	uintptr_t free_mem_beg = reinterpret_cast<uintptr_t>(free_mem.beg);
-	free_mem_beg = kstd::align_ceiled(free_mem_beg, PageTable_<pml>::size_shift);
-	if (free_mem_beg < (uintptr_t)free_mem.beg) [[unlikely]]
-		return LocalErr::Overflow;
+	if constexpr (pml > constants::max_pml_having_ps_bit) {
+		// there are no large pages at this page map level
+		return PageMapErr::None;
+	} else {
+		using NextPageTable = PageTable_<pml - 1>;
+
+		const PhysAddr next_pt_addr = allocator.alloc();
+		if (!next_pt_addr)
+			return PageMapErr::NoFreeMem;
+
+		auto *next_pt = static_cast<NextPageTable *>(allocator.to_virt(next_pt_addr));
+		const PhysAddr page_addr = entry.get_page_addr();
+		const PageEntryFlags flags = get_entry_flags(entry);
+		for (unsigned i = 0; i < NextPageTable::nr_entries; ++i) {
+			set_page_entry(next_pt->entries[i],
+				page_addr + i * NextPageTable::controlled_mem_per_entry, flags);
+		}
 
-	PhysAddr new_pt_addr = static_cast<PhysAddr>(free_mem_beg);
+		set_page_table_entry(entry, next_pt_addr);
+		set_entry_flags<SetEntryFlagsMode::PageTable>(entry, flags);
+		return PageMapErr::None;
+	}
+}
 
-	if (kstd::add_overflow(free_mem_beg, PageTable_<pml>::size)) [[unlikely]]
-		return LocalErr::NoFreeMemory;
+template<int pml> void PageTable_<pml>::try_merge_page_table(
+		PageTableEntry_<pml>& entry, LineAddr linaddr,
+		PageTableAllocator& allocator, TLBFlushBatch& tlb_batch)
+{
+	if constexpr (pml > constants::max_pml_having_ps_bit) {
+		// there are no large pages at this page map level
+		return;
+	} else {
+		using NextPageTable = PageTable_<pml - 1>;
+
+		if (!entry.is_present() || entry.maps_page())
+			return;
+
+		const auto *next_pt = get_page_table(entry, allocator);
+		const auto& first_entry = next_pt->entries[0];
+		if (!first_entry.is_present() || !first_entry.maps_page())
+			return;
+
+		const PhysAddr page_addr = first_entry.get_page_addr();
+		const PageEntryFlags flags = get_entry_flags(first_entry);
+		if (page_addr & (controlled_mem_per_entry - 1))
+			return;
+
+		for (unsigned i = 1; i < NextPageTable::nr_entries; ++i) {
+			const auto& next_entry = next_pt->entries[i];
+			if (!next_entry.is_present() || !next_entry.maps_page()
+			 || next_entry.get_page_addr() != page_addr
+					+ i * NextPageTable::controlled_mem_per_entry
+			 || get_entry_flags(next_entry) != flags)
+				return;
+		}
 
-	free_mem.beg = reinterpret_cast<kstd::Byte *>(free_mem_beg);
-	if (free_mem.beg >= free_mem.end)
-		return LocalErr::NoFreeMemory;
+		const PhysAddr next_pt_addr = entry.get_page_table_addr();
+		set_page_entry(entry, page_addr, flags);
+		// the translation stays the same, but the paging-structure caches
+		// may still point to the page table that is freed
+		tlb_batch.add_page_table(linaddr, entry.is_global(), next_pt_addr,
+				allocator);
+	}
+}
 
-	new ((void *)new_pt_addr) PageTable_<pml>();
-	return new_pt_addr;
+template<int pml> bool PageTable_<pml>::is_empty() const
+{
+	for (const auto& entry : entries) {
+		if (entry.is_present())
+			return false;
+	}
+	return true;
 }
 
+/* Define the page table class. */
+template class PageTable_<max_page_map_level>;
+
+
 template<SetEntryFlagsMode mode, int pml>
 static void set_entry_flags(PageTableEntry_<pml>& entry, PageEntryFlags flags)
 {
@@ -264,6 +507,8 @@ static void set_entry_flags(PageTableEntry_<pml>& entry, PageEntryFlags flags)
 				test_flag(flags, PageEntryFlags::Supervisor));
 		entry.set_execute_disabled(
 				test_flag(flags, PageEntryFlags::ExecuteDisabled));
+		entry.set_cache_disabled(
+				test_flag(flags, PageEntryFlags::CacheDisabled));
 	} else {
 		// in page table mode set the most permissive flags
 		entry.set_write_allowed(entry.is_write_allowed() ||
@@ -275,6 +520,39 @@ static void set_entry_flags(PageTableEntry_<pml>& entry, PageEntryFlags flags)
 	}
 }
 
+template<int pml>
+static PageEntryFlags get_entry_flags(const PageTableEntry_<pml>& entry)
+{
+	using kstd::switch_flag;
+
+	return switch_flag(PageEntryFlags::WriteAllowed, entry.is_write_allowed())
+		| switch_flag(PageEntryFlags::Supervisor, entry.is_supervisor())
+		| switch_flag(PageEntryFlags::Global, entry.is_global())
+		| switch_flag(PageEntryFlags::ExecuteDisabled, entry.is_execute_disabled())
+		| switch_flag(PageEntryFlags::CacheDisabled, entry.is_cache_disabled());
+}
+
+template<int pml>
+static void set_page_entry(PageTableEntry_<pml>& entry, PhysAddr page_addr,
+		PageEntryFlags flags)
+{
+	entry.clear();
+	entry.map_page(page_addr, kstd::test_flag(flags, PageEntryFlags::Global));
+	set_entry_flags<SetEntryFlagsMode::Page>(entry, flags);
+	entry.set_present(true);
+}
+
+template<int pml>
+static void set_page_table_entry(PageTableEntry_<pml>& entry, PhysAddr pt_addr)
+{
+	entry.clear();
+	entry.map_page_table(pt_addr);
+	entry.set_present(true);
+	entry.set_write_allowed(false);
+	entry.set_supervisor(true);
+	entry.set_execute_disabled(true);
+}
+
 static bool check_alignment(LineAddr linaddr_beg, PhysAddr phyaddr_beg, PageSize ps)
 {
 	return 	(linaddr_beg & (get_page_size_bytes(ps) - 1)) == 0 &&
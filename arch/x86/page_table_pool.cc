@@ -0,0 +1,56 @@
+#include <x86/paging/page_table_pool.h>
+
+#include <klibc/pages.h>
+
+
+namespace x86 {
+
+void PageTablePool::init(AllocFrame alloc_frame, FreeFrame free_frame)
+{
+	this->alloc_frame = alloc_frame;
+	this->free_frame = free_frame;
+	nr_frames = 0;
+}
+
+PhysAddr PageTablePool::alloc()
+{
+	if (nr_frames > 0) [[likely]]
+		return frames[--nr_frames];
+	return alloc_zeroed_frame(false);
+}
+
+void PageTablePool::free(PhysAddr pt_addr)
+{
+	// merged page tables still have their entries, so the frame goes back
+	// and gets zeroed again when it's needed
+	free_frame(pt_addr);
+}
+
+void *PageTablePool::to_virt(PhysAddr pt_addr) const
+{
+	return reinterpret_cast<void *>(direct_map_offset + pt_addr);
+}
+
+bool PageTablePool::refill_one()
+{
+	if (nr_frames == capacity)
+		return false;
+
+	// nothing reads the frame until it's taken, so it's zeroed around the
+	// caches instead of evicting what the CPU is working on
+	const PhysAddr frame = alloc_zeroed_frame(true);
+	if (!frame)
+		return false;
+	frames[nr_frames++] = frame;
+	return true;
+}
+
+PhysAddr PageTablePool::alloc_zeroed_frame(bool cold)
+{
+	const PhysAddr frame = alloc_frame();
+	if (frame)
+		klibc::zero_pages(to_virt(frame), 1, cold);
+	return frame;
+}
+
+}
@@ -0,0 +1,81 @@
+#include <x86/segmentation.h>
+
+
+namespace x86 {
+
+namespace {
+
+/* Code and data segment descriptor with the given access byte and flags,
+ * base and limit are ignored in the long mode. */
+constexpr uint64_t segment_descriptor(uint8_t access, uint8_t flags)
+{
+	return 0xFFFF | (uint64_t(0xF) << 48)
+		| (uint64_t(access) << 40) | (uint64_t(flags) << 52);
+}
+
+constexpr uint8_t code_access = 0x9A; /* present, code, readable */
+constexpr uint8_t data_access = 0x92; /* present, data, writable */
+constexpr uint8_t tss_access = 0x89; /* present, available 64bit TSS */
+constexpr uint8_t code_flags = 0xA; /* granularity, long mode */
+constexpr uint8_t data_flags = 0xC; /* granularity, 32bit */
+
+// only the bootstrap processor runs for now, so there's one of each
+TSS tss {.iomap_base = sizeof(TSS)};
+
+alignas(16) uint8_t ist_stacks[3][ist_stack_size];
+
+uint64_t gdt[] = {
+	0, /* null segment descriptor */
+	segment_descriptor(code_access, code_flags),
+	segment_descriptor(data_access, data_flags),
+	0, 0, /* TSS descriptor, it takes two entries */
+};
+
+struct [[gnu::packed]] GDT_Ptr {
+	uint16_t size;
+	uint64_t addr;
+};
+
+void set_tss_descriptor(uint64_t *entry, const TSS *tss)
+{
+	const auto base = reinterpret_cast<uint64_t>(tss);
+	const uint64_t limit = sizeof(TSS) - 1;
+
+	entry[0] = limit | ((base & 0xFFFFFF) << 16)
+		| (uint64_t(tss_access) << 40) | ((base >> 24 & 0xFF) << 56);
+	entry[1] = base >> 32;
+}
+
+}
+
+void setup_segmentation()
+{
+	for (unsigned int i = 0; i < 3; ++i)
+		tss.ist[i] = reinterpret_cast<uint64_t>(ist_stacks[i] + ist_stack_size);
+	set_tss_descriptor(&gdt[tss_selector / sizeof(uint64_t)], &tss);
+
+	const GDT_Ptr gdt_ptr {
+		.size = sizeof(gdt) - 1,
+		.addr = reinterpret_cast<uint64_t>(gdt),
+	};
+
+	// code segment can only be reloaded with a far return
+	asm volatile (
+		"lgdt %[gdt_ptr] 		\n"
+		"pushq %[code] 			\n"
+		"leaq 1f(%%rip), %%rax 		\n"
+		"pushq %%rax 			\n"
+		"lretq 				\n"
+		"1: 				\n"
+		"mov %[data], %%ds 		\n"
+		"mov %[data], %%es 		\n"
+		"mov %[data], %%ss 		\n"
+		"ltr %[tss] 			\n"
+		:: [gdt_ptr]"m"(gdt_ptr), [code]"i"(kernel_code_selector),
+		   [data]"r"(uint32_t(kernel_data_selector)),
+		   [tss]"r"(uint16_t(tss_selector))
+		: "rax", "memory"
+	);
+}
+
+}
@@ -0,0 +1,89 @@
+#include <x86/time/apic_timer.h>
+#include <x86/time/tsc.h>
+#include <x86/interrupts/apic.h>
+#include <x86/msr.h>
+
+
+namespace x86 {
+
+namespace {
+
+enum class TimerMode : uint32_t {
+	OneShot 	= 0 << 17,
+	Periodic 	= 1 << 17,
+	TSC_Deadline 	= 2 << 17,
+};
+
+constexpr uint32_t divide_by_1 = 0xB;
+
+/* TSC cycles the one-shot count is calibrated over. */
+constexpr uint64_t calibration_cycles = 1 << 22;
+
+bool tsc_deadline_mode = false;
+/* APIC timer ticks per TSC cycle as a 32.32 fixed point number. */
+uint64_t ticks_per_cycle = 0;
+
+void set_timer_lvt(TimerMode mode, unsigned int vector)
+{
+	write_apic(APIC_Reg::LVT_Timer, static_cast<uint32_t>(mode) | vector);
+}
+
+void calibrate_one_shot()
+{
+	write_apic(APIC_Reg::LVT_Timer, static_cast<uint32_t>(TimerMode::OneShot)
+			| apic_lvt_masked);
+	write_apic(APIC_Reg::TimerDivide, divide_by_1);
+
+	const uint64_t start = read_tsc();
+	write_apic(APIC_Reg::TimerInitialCount, UINT32_MAX);
+	while (read_tsc() - start < calibration_cycles)
+		asm volatile ("pause");
+	const uint32_t ticks = UINT32_MAX - read_apic(APIC_Reg::TimerCurrentCount);
+	const uint64_t cycles = read_tsc() - start;
+	write_apic(APIC_Reg::TimerInitialCount, 0);
+
+	ticks_per_cycle = (uint64_t(ticks) << 32) / cycles;
+}
+
+}
+
+void setup_apic_timer(bool tsc_deadline, InterruptHandler handler)
+{
+	tsc_deadline_mode = tsc_deadline;
+	set_interrupt_handler(apic_timer_vector, handler);
+
+	if (tsc_deadline_mode) {
+		set_timer_lvt(TimerMode::TSC_Deadline, apic_timer_vector);
+		// the LVT write has to land before the deadline MSR is written
+		asm volatile ("mfence" ::: "memory");
+		return;
+	}
+
+	calibrate_one_shot();
+	set_timer_lvt(TimerMode::OneShot, apic_timer_vector);
+}
+
+void set_apic_timer_deadline(uint64_t deadline)
+{
+	if (tsc_deadline_mode) {
+		write_msr(MSR::TSC_Deadline, deadline);
+		return;
+	}
+
+	const uint64_t now = read_tsc();
+	const uint64_t cycles = deadline > now ? deadline - now : 0;
+	const auto ticks = static_cast<unsigned __int128>(cycles) * ticks_per_cycle >> 32;
+	// a count of 0 stops the timer, so passed deadlines get the shortest one
+	const uint32_t count = ticks > UINT32_MAX ? UINT32_MAX : ticks ? uint32_t(ticks) : 1;
+	write_apic(APIC_Reg::TimerInitialCount, count);
+}
+
+void stop_apic_timer()
+{
+	if (tsc_deadline_mode)
+		write_msr(MSR::TSC_Deadline, 0);
+	else
+		write_apic(APIC_Reg::TimerInitialCount, 0);
+}
+
+}
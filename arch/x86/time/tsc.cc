@@ -0,0 +1,97 @@
+#include <x86/time/tsc.h>
+#include <x86/cpuid.h>
+#include <x86/port_io.h>
+
+
+namespace x86 {
+
+namespace {
+
+constexpr uint64_t pit_frequency = 1193182;
+constexpr uint16_t pit_channel2_data = 0x42;
+constexpr uint16_t pit_command = 0x43;
+/* Controls the gate of PIT channel 2 and the speaker, and reads its output. */
+constexpr uint16_t pit_channel2_control = 0x61;
+
+constexpr uint8_t pit_channel2_gate = 1 << 0;
+constexpr uint8_t pit_speaker_enable = 1 << 1;
+constexpr uint8_t pit_channel2_output = 1 << 5;
+/* Channel 2, low then high byte of the count, interrupt on terminal count. */
+constexpr uint8_t pit_channel2_one_shot = 0xB0;
+
+/* PIT ticks in each measurement, 20ms. */
+constexpr uint16_t calibration_ticks = pit_frequency / 50;
+constexpr unsigned int nr_calibration_rounds = 3;
+/* TSC cycles after which the PIT is taken as missing, seconds at any speed. */
+constexpr uint64_t pit_timeout_cycles = uint64_t(1) << 33;
+
+uint64_t get_cpuid_tsc_frequency()
+{
+	// TSC to core crystal clock ratio, the crystal frequency may be missing
+	const CPUID_Leaf ratio = read_cpuid_leaf(0x15);
+	if (ratio.eax && ratio.ebx && ratio.ecx)
+		return uint64_t(ratio.ecx) * ratio.ebx / ratio.eax;
+
+	// processor base frequency in MHz, which the TSC runs at
+	const CPUID_Leaf freq = read_cpuid_leaf(0x16);
+	return uint64_t(freq.eax & 0xFFFF) * 1000000;
+}
+
+/* Count the TSC cycles in calibration_ticks of the PIT, 0 if it never ends.
+ * The channel 2 output can be polled, unlike channel 0 it raises no
+ * interrupt. */
+uint64_t measure_pit_cycles()
+{
+	// disconnect the speaker and open the gate
+	const uint8_t control = inb(pit_channel2_control);
+	outb(pit_channel2_control, (control & ~pit_speaker_enable) | pit_channel2_gate);
+
+	outb(pit_command, pit_channel2_one_shot);
+	outb(pit_channel2_data, calibration_ticks & 0xFF);
+	outb(pit_channel2_data, calibration_ticks >> 8);
+
+	// the count starts once its high byte is written
+	const uint64_t start = read_tsc();
+	uint64_t cycles;
+	bool done;
+	do {
+		asm volatile ("pause");
+		cycles = read_tsc() - start;
+		done = inb(pit_channel2_control) & pit_channel2_output;
+	} while (!done && cycles < pit_timeout_cycles);
+
+	outb(pit_channel2_control, control);
+	return done ? cycles : 0;
+}
+
+uint64_t calibrate_tsc()
+{
+	// a delay in noticing the output only ever adds cycles, so the lowest
+	// measurement is the most accurate one
+	uint64_t cycles = UINT64_MAX;
+	for (unsigned int round = 0; round < nr_calibration_rounds; ++round) {
+		const uint64_t round_cycles = measure_pit_cycles();
+		if (!round_cycles)
+			return 0;
+		if (round_cycles < cycles)
+			cycles = round_cycles;
+	}
+	return cycles * pit_frequency / calibration_ticks;
+}
+
+}
+
+uint64_t get_tsc_frequency()
+{
+	const uint64_t frequency = get_cpuid_tsc_frequency();
+	return frequency ? frequency : calibrate_tsc();
+}
+
+bool is_tsc_invariant()
+{
+	ArchInfo arch_info;
+	cpuid__assume_cpuid_present(arch_info);
+	return kstd::test_flag(arch_info.ext_feature_flags, ExtFeatureFlags::InvariantTSC);
+}
+
+}
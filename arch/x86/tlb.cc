@@ -0,0 +1,119 @@
+#include <x86/paging/tlb.h>
+#include <x86/paging/page_map.h>
+
+
+namespace x86 {
+
+static bool pge_supported = false;
+static bool pcid_enabled = false;
+static bool invpcid_enabled = false;
+
+void setup_tlb(const ArchInfo& info)
+{
+	pge_supported = kstd::test_flag(info.feature_flags, FeatureFlags::PGE);
+	// flushing the other PCIDs without INVPCID relies on CR4.PGE, which
+	// every CPU supporting PCIDs has
+	if (pge_supported && kstd::test_flag(info.feature_flags, FeatureFlags::PCID)) {
+		write_cr4_flags(read_cr4_flags() | CR4_Flags::PCIDE);
+		pcid_enabled = true;
+	}
+	invpcid_enabled = kstd::test_flag(info.feature_flags, FeatureFlags::INVPCID);
+}
+
+bool is_pcid_enabled()
+{
+	return pcid_enabled;
+}
+
+bool is_invpcid_enabled()
+{
+	return invpcid_enabled;
+}
+
+void flush_tlb_global()
+{
+	if (invpcid_enabled) {
+		invpcid(InvpcidType::AllGlobal, 0, 0);
+		return;
+	}
+
+	if (pge_supported) {
+		// changing CR4.PGE either way flushes everything, the global pages
+		// and all PCIDs included
+		const auto cr4_val = read_cr4_flags();
+		write_cr4_flags(cr4_val ^ CR4_Flags::PGE);
+		write_cr4_flags(cr4_val);
+	} else {
+		// without PGE there are no global pages and no PCIDs
+		flush_tlb();
+	}
+}
+
+void TLBFlushBatch::add_page(LineAddr linaddr, bool global)
+{
+	has_global |= global;
+	if (nr_pages < max_nr_pages)
+		pages[nr_pages] = canonical_linear_addr(linaddr);
+	++nr_pages;
+}
+
+void TLBFlushBatch::add_page_table(LineAddr linaddr, bool global, PhysAddr pt_addr,
+		PageTableAllocator& allocator)
+{
+	// any invalidation drops the paging-structure caches of the PCID
+	add_page(linaddr, global);
+	*static_cast<PhysAddr *>(allocator.to_virt(pt_addr)) = freed_page_tables;
+	freed_page_tables = pt_addr;
+	pt_allocator = &allocator;
+}
+
+void TLBFlushBatch::free_page_tables()
+{
+	while (freed_page_tables) {
+		const PhysAddr pt_addr = freed_page_tables;
+		freed_page_tables = *static_cast<PhysAddr *>(pt_allocator->to_virt(pt_addr));
+		pt_allocator->free(pt_addr);
+	}
+}
+
+void TLBFlushBatch::flush()
+{
+	if (nr_pages > max_nr_pages) {
+		if (has_global)
+			flush_tlb_global();
+		else
+			flush_tlb();
+	} else {
+		for (unsigned int i = 0; i < nr_pages; ++i)
+			invlpg(pages[i]);
+	}
+
+	nr_pages = 0;
+	has_global = false;
+	free_page_tables();
+}
+
+void TLBFlushBatch::flush_other(unsigned long pcid)
+{
+	if (nr_pages > max_nr_pages) {
+		if (has_global)
+			flush_tlb_global();
+		else if (pcid)
+			invpcid(InvpcidType::Context, pcid, 0);
+	} else {
+		for (unsigned int i = 0; i < nr_pages; ++i) {
+			// INVPCID leaves the global pages alone, INVLPG gets them
+			// whatever PCID is current
+			if (has_global)
+				invlpg(pages[i]);
+			if (pcid)
+				invpcid(InvpcidType::Address, pcid, pages[i]);
+		}
+	}
+
+	nr_pages = 0;
+	has_global = false;
+	free_page_tables();
+}
+
+}
@@ -0,0 +1,28 @@
+#include <x86/utils/serial/ostream.h>
+
+#include <string.h>
+
+
+namespace x86::utils {
+
+void Serial_OStream::putc(const char c)
+{
+	uart.putc(c);
+}
+
+void Serial_OStream::puts(const char *str)
+{
+	uart.write(str, strlen(str));
+}
+
+void Serial_OStream::write(const char *str, size_t len)
+{
+	uart.write(str, len);
+}
+
+UART16550& Serial_OStream::get_uart()
+{
+	return uart;
+}
+
+}
@@ -0,0 +1,110 @@
+#include <x86/utils/serial/uart.h>
+#include <x86/port_io.h>
+#include <x86/system.h>
+
+
+namespace x86::utils {
+
+/* Register offsets from the base port. The divisor latch replaces the
+ * data and interrupt enable registers while LCR.DLAB is set. */
+static constexpr uint16_t reg_data = 0;
+static constexpr uint16_t reg_int_enable = 1;
+static constexpr uint16_t reg_divisor_low = 0;
+static constexpr uint16_t reg_divisor_high = 1;
+static constexpr uint16_t reg_int_ident = 2;
+static constexpr uint16_t reg_fifo_ctrl = 2;
+static constexpr uint16_t reg_line_ctrl = 3;
+static constexpr uint16_t reg_modem_ctrl = 4;
+static constexpr uint16_t reg_line_status = 5;
+static constexpr uint16_t reg_scratch = 7;
+
+static constexpr uint8_t line_ctrl_8n1 = 0x03;
+static constexpr uint8_t line_ctrl_dlab = 0x80;
+/* Enable and clear both FIFOs, receive interrupt at 14 bytes. */
+static constexpr uint8_t fifo_ctrl_enable = 0xC7;
+/* DTR, RTS and OUT2, which connects the interrupt line. */
+static constexpr uint8_t modem_ctrl_default = 0x0B;
+/* Both FIFOs enabled, as read from IIR bits 7:6. */
+static constexpr uint8_t int_ident_fifo_enabled = 0xC0;
+static constexpr size_t enabled_fifo_size = 16;
+/* The transmitter holding register, or the FIFO in FIFO mode, is empty. */
+static constexpr uint8_t line_status_tx_empty = 0x20;
+
+UART16550::UART16550(uint16_t port, unsigned int baud_rate) : port(port)
+{
+	// a missing UART doesn't keep what's written to it
+	outb(port + reg_scratch, 0x5A);
+	if (inb(port + reg_scratch) != 0x5A)
+		return;
+	present = true;
+
+	const uint16_t divisor = max_baud_rate / baud_rate;
+	outb(port + reg_int_enable, 0);
+	outb(port + reg_line_ctrl, line_ctrl_dlab);
+	outb(port + reg_divisor_low, divisor & 0xFF);
+	outb(port + reg_divisor_high, divisor >> 8);
+	outb(port + reg_line_ctrl, line_ctrl_8n1);
+	outb(port + reg_fifo_ctrl, fifo_ctrl_enable);
+	// an 8250 or a 16450 has no FIFO, and the one of the original 16550
+	// doesn't work
+	if ((inb(port + reg_int_ident) & int_ident_fifo_enabled) == int_ident_fifo_enabled)
+		fifo_size = enabled_fifo_size;
+	outb(port + reg_modem_ctrl, modem_ctrl_default);
+}
+
+void UART16550::putc(const char c)
+{
+	write(&c, 1);
+}
+
+void UART16550::write(const char *str, size_t len)
+{
+	if (!present)
+		return;
+
+	// the transmitter is polled with interrupts enabled, draining the
+	// queue at the baud rate takes milliseconds
+	size_t i = 0;
+	while (true) {
+		const unsigned long flags = irq_save();
+		for (; i < len && get_tx_room() >= 2; ++i) {
+			// terminals expect the carriage return
+			if (str[i] == '\n')
+				enqueue('\r');
+			enqueue(str[i]);
+		}
+		fill_fifo();
+		const bool done = i == len && tx_head == tx_tail;
+		irq_restore(flags);
+
+		if (done)
+			return;
+		wait_for_tx_empty();
+	}
+}
+
+inline size_t UART16550::get_tx_room() const
+{
+	return tx_ring_size - (tx_head - tx_tail);
+}
+
+inline void UART16550::enqueue(char c)
+{
+	tx_ring[tx_head++ % tx_ring_size] = c;
+}
+
+void UART16550::fill_fifo()
+{
+	if (!(inb(port + reg_line_status) & line_status_tx_empty))
+		return;
+	for (size_t i = 0; i < fifo_size && tx_tail != tx_head; ++i)
+		outb(port + reg_data, tx_ring[tx_tail++ % tx_ring_size]);
+}
+
+inline void UART16550::wait_for_tx_empty()
+{
+	while (!(inb(port + reg_line_status) & line_status_tx_empty))
+		asm volatile ("pause");
+}
+
+}
@@ -9,12 +9,28 @@
 
 namespace x86::utils {
 
+// the .bss of the 32bit entry code is discarded
+__attribute__((section(".data"))) VGAConsole::Screen VGAConsole::screen;
+
 VGAConsole::VGAConsole()
 {
+	if (!screen.loaded) {
+		// keep what the previous users of the screen left
+		memcpy(screen.rows, buf_start, tot_nr_bytes);
+		screen.first_row = 0;
+		screen.dirty_rows = 0;
+		screen.loaded = true;
+	}
 	set_cursor(0, 0);
 }
 
 void VGAConsole::putc(const char c)
+{
+	put_char(c);
+	flush();
+}
+
+void VGAConsole::put_char(const char c)
 {
 	switch (c) {
 	case '\n':
@@ -68,14 +84,67 @@ void VGAConsole::putc(const char c)
 
 void VGAConsole::puts(const char *str)
 {
-	while (char c = *str++)
-		putc(c);
+	write(str, strlen(str));
 }
 
 void VGAConsole::write(const char *str, size_t len)
 {
-	while (len--)
-		putc(*str++);
+	while (len) {
+		// plain text is stored in runs, the rest goes through the state
+		// machine one character at a time
+		const size_t run_len = mode == Mode::Normal ? get_printable_len(str, len) : 0;
+		if (run_len) {
+			put_normal_run(str, run_len);
+			str += run_len;
+			len -= run_len;
+		} else {
+			put_char(*str++);
+			--len;
+		}
+	}
+	flush();
+}
+
+size_t VGAConsole::get_printable_len(const char *str, size_t len)
+{
+	using Word = unsigned long;
+	using UnalignedWord = Word __attribute__((aligned(1), may_alias));
+	constexpr Word ones = Word(-1) / 0xFF;
+
+	// skip the words without control characters, bytes below 0x20 or
+	// above 0x7E, a word at a time
+	size_t i = 0;
+	for (; len - i >= sizeof(Word); i += sizeof(Word)) {
+		const Word word = *reinterpret_cast<const UnalignedWord *>(str + i);
+		const Word below = (word - ones * 0x20) & ~word;
+		const Word above = (word + ones * (0x7F - 0x7E)) | word;
+		if ((below | above) & (ones * 0x80))
+			break;
+	}
+
+	for (; i < len && 0x1F < str[i] && str[i] < 0x7F; ++i);
+	return i;
+}
+
+void VGAConsole::put_normal_run(const char *str, size_t len)
+{
+	while (len) {
+		const size_t nr_cells = kstd::min(len, size_t(nr_cols - curr_x));
+		char *cell = get_row(curr_y) + curr_x * bytes_per_cell;
+		for (size_t i = 0; i < nr_cells; ++i) {
+			cell[i * bytes_per_cell] = str[i];
+			cell[i * bytes_per_cell + 1] = curr_color;
+		}
+		screen.dirty_rows |= uint32_t(1) << curr_y;
+		str += nr_cells;
+		len -= nr_cells;
+
+		// stand on the last cell written and move right from it, which
+		// wraps and scrolls like a character at a time would
+		curr_x += nr_cells - 1;
+		curr_cell += nr_cells - 1;
+		move_cursor_right();
+	}
 }
 
 inline void VGAConsole::put_normal_char(char c)
@@ -168,34 +237,34 @@ void VGAConsole::move_screen(long lines)
 
 	// positive number of lines corresponds to moving the screen up
 	// negative number of lines corresponds to moving the screen down
-
-	char *dst, *src; long len;
-	long cells_outta_screen = nr_cols * lines;
-	long bytes_outta_screen = cells_outta_screen * bytes_per_cell;
-
-	long clear_beg_off; long clear_nr_bytes;
+	// the lines that scroll in are the ones that went out, cleared
 
 	if (lines > 0) {
-		dst = buf_start;
-		src = buf_start + bytes_outta_screen;
-		len = tot_nr_bytes - bytes_outta_screen;
-		clear_beg_off = tot_nr_bytes - bytes_outta_screen;
-		clear_nr_bytes = bytes_outta_screen;
+		screen.first_row = (screen.first_row + lines) % nr_rows;
+		for (long y = nr_rows - lines; y < nr_rows; ++y)
+			memset(get_row(y), 0, bytes_per_row);
 	} else {
-		dst = buf_start - bytes_outta_screen;
-		src = buf_start;
-		len = tot_nr_bytes + bytes_outta_screen;
-		clear_beg_off = 0;
-		clear_nr_bytes = -bytes_outta_screen;
+		screen.first_row = (screen.first_row + nr_rows + lines) % nr_rows;
+		for (long y = 0; y < -lines; ++y)
+			memset(get_row(y), 0, bytes_per_row);
 	}
-
-	memmove(dst, src, len); // move characters
-	memset(buf_start + clear_beg_off, 0, clear_nr_bytes); // clear what was left
+	screen.dirty_rows = (uint32_t(1) << nr_rows) - 1;
 }
 
 inline void VGAConsole::clear_screen()
 {
-	memset(buf_start, 0, tot_nr_bytes);
+	memset(screen.rows, 0, tot_nr_bytes);
+	screen.first_row = 0;
+	screen.dirty_rows = (uint32_t(1) << nr_rows) - 1;
+}
+
+void VGAConsole::flush()
+{
+	for (uint32_t dirty = screen.dirty_rows; dirty; dirty &= dirty - 1) {
+		const long y = __builtin_ctz(dirty);
+		memcpy(buf_start + y * bytes_per_row, get_row(y), bytes_per_row);
+	}
+	screen.dirty_rows = 0;
 }
 
 inline void VGAConsole::reset()
@@ -240,9 +309,15 @@ void VGAConsole::set_cell(long cell)
 
 inline void VGAConsole::set_char(char c)
 {
-	long bytes_off = curr_cell * bytes_per_cell;
-	buf_start[bytes_off] = c;
-	buf_start[bytes_off + 1] = curr_color;
+	char *cell = get_row(curr_y) + curr_x * bytes_per_cell;
+	cell[0] = c;
+	cell[1] = curr_color;
+	screen.dirty_rows |= uint32_t(1) << curr_y;
+}
+
+inline char *VGAConsole::get_row(long y)
+{
+	return screen.rows[(screen.first_row + y) % nr_rows];
 }
 
 /* Check if the char is a valid escape command exiting char. */
@@ -0,0 +1,528 @@
+#ifndef _KSTD__FORMAT_H__
+#define _KSTD__FORMAT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <kstd/type_traits.h>
+#include <kstd/concepts.h>
+#include <kstd/limits.h>
+#include <kstd/io.h>
+
+#include <klibc/dec_format.h>
+
+/*
+ * Formatting with format strings checked while compiling:
+ *
+ *	kstd::print(kout, "{} frames at {:#x}\n", nr_frames, addr);
+ *
+ * Each "{}" is replaced with the next argument, "{{" and "}}" stand for
+ * literal braces. A field may have a spec after a colon:
+ *
+ *	{:[<|>][#][0][width][type]}
+ *
+ * '<' and '>' align the field left or right within width, '#' adds the 0x,
+ * 0b or 0 prefix of the base, '0' pads numbers with zeros after the sign and
+ * prefix. The types are d, x, X, b and o for integers, c for characters,
+ * s for strings and bools and p for pointers.
+ *
+ * The format string is parsed once when compiling, a wrong number of
+ * arguments or a spec not fitting its argument fails the build. The text is
+ * rendered into a buffer on the stack and handed to the stream with a single
+ * write().
+ */
+
+namespace kstd {
+
+enum class FormatArgKind {
+	None,
+	Bool,
+	Char,
+	Integral,
+	String,
+	Pointer,
+};
+
+template<typename T>
+struct FormatArg {
+	static constexpr FormatArgKind kind = FormatArgKind::None;
+};
+
+template<Integral T>
+struct FormatArg<T> {
+	static constexpr FormatArgKind kind = FormatArgKind::Integral;
+};
+
+template<> struct FormatArg<bool> {
+	static constexpr FormatArgKind kind = FormatArgKind::Bool;
+};
+
+template<> struct FormatArg<char> {
+	static constexpr FormatArgKind kind = FormatArgKind::Char;
+};
+
+template<typename T>
+struct FormatArg<T *> {
+	static constexpr FormatArgKind kind = FormatArgKind::Pointer;
+};
+
+template<> struct FormatArg<char *> {
+	static constexpr FormatArgKind kind = FormatArgKind::String;
+};
+
+template<> struct FormatArg<const char *> {
+	static constexpr FormatArgKind kind = FormatArgKind::String;
+};
+
+template<size_t N>
+struct FormatArg<char[N]> {
+	static constexpr FormatArgKind kind = FormatArgKind::String;
+};
+
+template<size_t N>
+struct FormatArg<const char[N]> {
+	static constexpr FormatArgKind kind = FormatArgKind::String;
+};
+
+
+enum class FormatAlign : uint8_t {
+	Default,
+	Left,
+	Right,
+};
+
+struct FormatSpec {
+	char type = 0;
+	FormatAlign align = FormatAlign::Default;
+	bool alt = false;
+	bool zero_fill = false;
+	uint8_t width = 0;
+};
+
+/* Literal text optionally followed by a replacement field. */
+struct FormatSegment {
+	uint16_t lit_start = 0;
+	uint16_t lit_len = 0;
+	bool has_arg = false;
+	FormatSpec spec;
+};
+
+/* Called only while parsing a bad format string when compiling. Not being
+ * constexpr turns the call into a compile error showing the message. */
+void format_error(const char *msg);
+
+
+/* Buffer the formatted text is rendered into. When full, it's either handed
+ * to the stream or, without a stream, the rest of the text is dropped. */
+class FormatBuffer {
+public:
+	FormatBuffer(char *buf, size_t size, OStream *stream)
+		: buf(buf), pos(buf), end(buf + size), stream(stream) {}
+
+	void put(const char *str, size_t len);
+	void put(char c);
+	void fill(char c, size_t cnt);
+	/* Hand the buffered text to the stream. */
+	void flush();
+
+	size_t size() const { return pos - buf; }
+
+private:
+	bool make_room();
+
+	char *const buf;
+	char *pos;
+	char *end;
+	OStream *const stream;
+};
+
+inline bool FormatBuffer::make_room()
+{
+	if (!stream) {
+		end = pos;
+		return false;
+	}
+	flush();
+	return true;
+}
+
+inline void FormatBuffer::put(const char *str, size_t len)
+{
+	while (len > size_t(end - pos)) {
+		const size_t part = end - pos;
+		memcpy(pos, str, part);
+		pos += part;
+		str += part;
+		len -= part;
+		if (!make_room())
+			return;
+	}
+	memcpy(pos, str, len);
+	pos += len;
+}
+
+inline void FormatBuffer::put(char c)
+{
+	if (pos == end && !make_room())
+		return;
+	*pos++ = c;
+}
+
+inline void FormatBuffer::fill(char c, size_t cnt)
+{
+	while (cnt > size_t(end - pos)) {
+		const size_t part = end - pos;
+		memset(pos, c, part);
+		pos += part;
+		cnt -= part;
+		if (!make_room())
+			return;
+	}
+	memset(pos, c, cnt);
+	pos += cnt;
+}
+
+inline void FormatBuffer::flush()
+{
+	if (pos != buf)
+		stream->write(buf, pos - buf);
+	pos = buf;
+}
+
+
+/* Put a field padded to the width of its spec. The prefix (sign and base)
+ * goes in front of the zeros padding numbers. */
+inline void format_field(FormatBuffer& out, const FormatSpec& spec, FormatAlign align,
+		const char *prefix, size_t prefix_len, const char *str, size_t len)
+{
+	const size_t field_len = prefix_len + len;
+	const size_t pad = spec.width > field_len ? spec.width - field_len : 0;
+
+	if (spec.zero_fill) {
+		out.put(prefix, prefix_len);
+		out.fill('0', pad);
+		out.put(str, len);
+		return;
+	}
+
+	if (align == FormatAlign::Right)
+		out.fill(' ', pad);
+	out.put(prefix, prefix_len);
+	out.put(str, len);
+	if (align == FormatAlign::Left)
+		out.fill(' ', pad);
+}
+
+/* Write the digits of a base that is a power of two so they end right
+ * before end and return where they start. */
+template<typename UIntegralT>
+inline char *format_pow2(char *end, UIntegralT val, unsigned int shift, bool upper)
+{
+	const char *const digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	const UIntegralT mask = (UIntegralT(1) << shift) - 1;
+
+	do {
+		*--end = digits[val & mask];
+		val >>= shift;
+	} while (val != 0);
+	return end;
+}
+
+template<Integral IntegralT>
+void format_integral(FormatBuffer& out, const FormatSpec& spec, IntegralT val)
+{
+	using UIntegralT = typename Unsigned<IntegralT>::Type;
+	const bool is_neg = val < 0;
+	// negated unsigned, the most negative value has no signed opposite
+	const UIntegralT u_val = is_neg ? UIntegralT(0) - UIntegralT(val) : UIntegralT(val);
+
+	char digits[IntegralLimits<UIntegralT>::digits2()];
+	char *const digits_end = digits + sizeof(digits);
+	char *digits_start;
+	const char *base_prefix = "";
+
+	switch (spec.type) {
+	case 'x':
+		digits_start = format_pow2(digits_end, u_val, 4, false);
+		base_prefix = "0x";
+		break;
+	case 'X':
+		digits_start = format_pow2(digits_end, u_val, 4, true);
+		base_prefix = "0X";
+		break;
+	case 'b':
+		digits_start = format_pow2(digits_end, u_val, 1, false);
+		base_prefix = "0b";
+		break;
+	case 'o':
+		digits_start = format_pow2(digits_end, u_val, 3, false);
+		base_prefix = u_val != 0 ? "0" : "";
+		break;
+	default:
+		digits_start = klibc::format_dec(digits_end, u_val);
+		break;
+	}
+
+	char prefix[3];
+	size_t prefix_len = 0;
+	if (is_neg)
+		prefix[prefix_len++] = '-';
+	if (spec.alt) {
+		for (; *base_prefix; ++base_prefix)
+			prefix[prefix_len++] = *base_prefix;
+	}
+
+	const FormatAlign align = spec.align == FormatAlign::Default
+				? FormatAlign::Right : spec.align;
+	format_field(out, spec, align, prefix, prefix_len,
+			digits_start, digits_end - digits_start);
+}
+
+inline void format_text(FormatBuffer& out, const FormatSpec& spec, const char *str, size_t len)
+{
+	const FormatAlign align = spec.align == FormatAlign::Default
+				? FormatAlign::Left : spec.align;
+	if (spec.width == 0)
+		out.put(str, len);
+	else
+		format_field(out, spec, align, "", 0, str, len);
+}
+
+/* Render one argument, the writer is picked by the type of the argument. */
+template<typename T>
+void format_arg(FormatBuffer& out, const FormatSpec& spec, const T& arg)
+{
+	constexpr FormatArgKind kind = FormatArg<T>::kind;
+
+	if constexpr (kind == FormatArgKind::Bool) {
+		if (spec.type == 's')
+			format_text(out, spec, arg ? "true" : "false", arg ? 4 : 5);
+		else
+			format_integral(out, spec, static_cast<unsigned int>(arg));
+	} else if constexpr (kind == FormatArgKind::Char) {
+		if (spec.type == 'c')
+			format_text(out, spec, &arg, 1);
+		else
+			format_integral(out, spec, static_cast<unsigned char>(arg));
+	} else if constexpr (kind == FormatArgKind::Integral) {
+		format_integral(out, spec, arg);
+	} else if constexpr (kind == FormatArgKind::String) {
+		const char *const str = arg;
+		format_text(out, spec, str, strlen(str));
+	} else if constexpr (kind == FormatArgKind::Pointer) {
+		FormatSpec ptr_spec = spec;
+		ptr_spec.type = 'x';
+		ptr_spec.alt = true;
+		format_integral(out, ptr_spec, reinterpret_cast<uintptr_t>(arg));
+	}
+}
+
+
+/* Format string parsed when compiling. */
+template<typename... Args>
+class BasicFormatString {
+	static_assert(((FormatArg<Args>::kind != FormatArgKind::None) && ...),
+			"Argument type can't be formatted.");
+
+public:
+	consteval BasicFormatString(const char *str);
+
+	/* Render the text and the arguments into a buffer. */
+	void render(FormatBuffer& out, const Args&... args) const;
+
+private:
+	/* How many escaped braces a format string may contain. */
+	static constexpr unsigned int max_escapes = 8;
+	static constexpr unsigned int max_segments = sizeof...(Args) + 1 + max_escapes;
+
+	consteval void add_segment(size_t lit_start, size_t lit_end, bool has_arg,
+			FormatSpec spec = {});
+	static consteval FormatSpec parse_spec(const char *str, size_t& pos, FormatArgKind kind);
+
+	const char *str;
+	FormatSegment segments[max_segments];
+	unsigned int nr_segments = 0;
+};
+
+template<typename... Args>
+consteval BasicFormatString<Args...>::BasicFormatString(const char *str) : str(str)
+{
+	constexpr FormatArgKind kinds[] = {FormatArg<Args>::kind..., FormatArgKind::None};
+	size_t pos = 0;
+	size_t lit_start = 0;
+	unsigned int arg = 0;
+
+	while (str[pos] != '\0') {
+		if (str[pos] == '{' && str[pos + 1] == '{') {
+			// keep one brace in the literal and skip the other
+			add_segment(lit_start, pos + 1, false);
+			pos += 2;
+			lit_start = pos;
+		} else if (str[pos] == '{') {
+			const size_t lit_end = pos++;
+			if (arg == sizeof...(Args))
+				format_error("More replacement fields than arguments.");
+			const FormatSpec spec = parse_spec(str, pos, kinds[arg++]);
+			add_segment(lit_start, lit_end, true, spec);
+			lit_start = pos;
+		} else if (str[pos] == '}') {
+			if (str[pos + 1] != '}')
+				format_error("Unmatched '}' in format string.");
+			add_segment(lit_start, pos + 1, false);
+			pos += 2;
+			lit_start = pos;
+		} else {
+			++pos;
+		}
+	}
+	if (arg != sizeof...(Args))
+		format_error("More arguments than replacement fields.");
+	add_segment(lit_start, pos, false);
+}
+
+template<typename... Args>
+consteval void BasicFormatString<Args...>::add_segment(size_t lit_start, size_t lit_end,
+		bool has_arg, FormatSpec spec)
+{
+	if (nr_segments == max_segments)
+		format_error("Too many escaped braces in format string.");
+	if (lit_end > UINT16_MAX)
+		format_error("Format string too long.");
+
+	FormatSegment& segment = segments[nr_segments++];
+	segment.lit_start = lit_start;
+	segment.lit_len = lit_end - lit_start;
+	segment.has_arg = has_arg;
+	segment.spec = spec;
+}
+
+template<typename... Args>
+consteval FormatSpec BasicFormatString<Args...>::parse_spec(const char *str, size_t& pos,
+		FormatArgKind kind)
+{
+	FormatSpec spec;
+
+	if (str[pos] >= '0' && str[pos] <= '9')
+		format_error("Argument indexes aren't supported.");
+	if (str[pos] == ':') {
+		++pos;
+		if (str[pos] == '<' || str[pos] == '>')
+			spec.align = str[pos++] == '<' ? FormatAlign::Left : FormatAlign::Right;
+		if (str[pos] == '#') {
+			spec.alt = true;
+			++pos;
+		}
+		if (str[pos] == '0') {
+			spec.zero_fill = true;
+			++pos;
+		}
+		unsigned int width = 0;
+		for (; str[pos] >= '0' && str[pos] <= '9'; ++pos) {
+			width = width * 10 + (str[pos] - '0');
+			if (width > UINT8_MAX)
+				format_error("Field width too big.");
+		}
+		spec.width = width;
+		if (str[pos] != '}' && str[pos] != '\0')
+			spec.type = str[pos++];
+	}
+	if (str[pos] != '}')
+		format_error("Bad replacement field in format string.");
+	++pos;
+
+	// check the spec fits the argument, and pick the type it defaults to
+	const char *types = "";
+	switch (kind) {
+	case FormatArgKind::Bool:
+		types = "sdxXbo";
+		break;
+	case FormatArgKind::Char:
+		types = "cdxXbo";
+		break;
+	case FormatArgKind::Integral:
+		types = "dxXbo";
+		break;
+	case FormatArgKind::String:
+		types = "s";
+		break;
+	case FormatArgKind::Pointer:
+		types = "p";
+		break;
+	default:
+		break;
+	}
+	if (spec.type == 0)
+		spec.type = types[0];
+	while (*types && *types != spec.type)
+		++types;
+	if (*types == '\0')
+		format_error("Format type doesn't fit the argument.");
+
+	const bool is_numeric = spec.type != 's' && spec.type != 'c';
+	if (spec.zero_fill && !is_numeric)
+		format_error("Only numbers can be padded with zeros.");
+	if (spec.zero_fill && spec.align != FormatAlign::Default)
+		format_error("Numbers padded with zeros can't be aligned.");
+	if (spec.alt && (spec.type == 'd' || !is_numeric))
+		format_error("Only x, X, b and o have a prefix.");
+	return spec;
+}
+
+template<typename... Args>
+void BasicFormatString<Args...>::render(FormatBuffer& out, const Args&... args) const
+{
+	const FormatSegment *segment = segments;
+	auto put_literal = [&](const FormatSegment& segment) {
+		out.put(str + segment.lit_start, segment.lit_len);
+	};
+	[[maybe_unused]] auto put_arg = [&](const auto& arg) {
+		// segments ended by escaped braces have no field
+		for (; !segment->has_arg; ++segment)
+			put_literal(*segment);
+		put_literal(*segment);
+		format_arg(out, segment->spec, arg);
+		++segment;
+	};
+
+	(put_arg(args), ...);
+	for (; segment != segments + nr_segments; ++segment)
+		put_literal(*segment);
+}
+
+/* The argument types are only deduced from the arguments, the format string
+ * is then checked against them. */
+template<typename... Args>
+using FormatString = BasicFormatString<typename TypeIdentity<Args>::Type...>;
+
+/* How much text print() collects on the stack before writing it out. */
+constexpr size_t format_buffer_size = 256;
+
+/* Write the formatted text to the stream. Text up to format_buffer_size
+ * characters long is written with a single write(). */
+template<typename... Args>
+void print(OStream& stream, FormatString<Args...> fmt, const Args&... args)
+{
+	char buf[format_buffer_size];
+	FormatBuffer out(buf, sizeof(buf), &stream);
+	fmt.render(out, args...);
+	out.flush();
+}
+
+/* Format the text into buf, terminated with a null character. Text not
+ * fitting is cut off. Returns the length of the text. */
+template<typename... Args>
+size_t format_to(char *buf, size_t size, FormatString<Args...> fmt, const Args&... args)
+{
+	if (size == 0)
+		return 0;
+
+	FormatBuffer out(buf, size - 1, nullptr);
+	fmt.render(out, args...);
+	buf[out.size()] = '\0';
+	return out.size();
+}
+
+}
+
+#endif
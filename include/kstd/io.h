@@ -10,6 +10,8 @@
 #include <kstd/limits.h>
 #include <kstd/new.h>
 
+#include <klibc/dec_format.h>
+
 namespace kstd {
 
 enum class StrCase {
@@ -181,21 +183,19 @@ void Basic_OStream<CharT>::write_integral_dec(IntegralT integral)
 	const bool is_neg = integral < 0;
 	constexpr int buf_len = kstd::IntegralLimits<IntegralT>::digits10()
 				+ is_signed_v<IntegralT>;
-	CharT buffer[buf_len] {fill_char};
-	CharT *buf_start = buffer + buf_len;
+	CharT buffer[buf_len];
+	CharT *const buf_end = buffer + buf_len;
 
 	using UIntegralT = typename Unsigned<IntegralT>::Type;
-	UIntegralT u_integral = is_neg ? -integral : integral;
-
-	do {
-		*--buf_start = (u_integral % 10) + '0';
-		u_integral /= 10;
-	} while (u_integral != 0);
+	// negated unsigned, the most negative value has no signed opposite
+	const UIntegralT u_integral = is_neg ? UIntegralT(0) - UIntegralT(integral)
+					: UIntegralT(integral);
 
+	CharT *buf_start = klibc::format_dec(buf_end, u_integral);
 	if (is_neg)
 		*--buf_start = '-';
 
-	write_integral_str(buf_start, buf_len - (buf_start - buffer));
+	write_integral_str(buf_start, buf_end - buf_start);
 }
 
 template<typename CharT> template<Integral IntegralT>
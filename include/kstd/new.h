@@ -3,30 +3,32 @@
 
 #include <stddef.h>
 
-inline void *operator new(size_t size, void *ptr)
-{
-	return ptr;
-}
+namespace std {
 
-inline void operator delete(void *ptr) noexcept
-{
-	return;
-}
+enum class align_val_t : size_t {};
 
-inline void operator delete[](void *ptr) noexcept
-{
-	return;
 }
 
-inline void operator delete(void *ptr, size_t size) noexcept
+inline void *operator new(size_t size, void *ptr) noexcept
 {
-	return;
+	return ptr;
 }
 
-inline void operator delete[](void *ptr, size_t size) noexcept
-{
-	return;
-}
+/* Global allocation functions. They are noexcept as the kernel has no
+ * exceptions, so a failed allocation shows up as a nullptr new-expression. */
+void *operator new(size_t size) noexcept;
+void *operator new[](size_t size) noexcept;
+void *operator new(size_t size, std::align_val_t align) noexcept;
+void *operator new[](size_t size, std::align_val_t align) noexcept;
+
+void operator delete(void *ptr) noexcept;
+void operator delete[](void *ptr) noexcept;
+void operator delete(void *ptr, size_t size) noexcept;
+void operator delete[](void *ptr, size_t size) noexcept;
+void operator delete(void *ptr, std::align_val_t align) noexcept;
+void operator delete[](void *ptr, std::align_val_t align) noexcept;
+void operator delete(void *ptr, size_t size, std::align_val_t align) noexcept;
+void operator delete[](void *ptr, size_t size, std::align_val_t align) noexcept;
 
 
 #endif
@@ -0,0 +1,321 @@
+#ifndef _KSTD__RBTREE_H__
+#define _KSTD__RBTREE_H__
+
+namespace kstd {
+
+/* Links of an element of an RBTree, the elements derive from it. */
+struct RBNode {
+	RBNode *parent = nullptr;
+	RBNode *left = nullptr;
+	RBNode *right = nullptr;
+	bool red = false;
+};
+
+/* Intrusive red-black tree of elements of type T, which derive from RBNode,
+ * ordered by Less(const T&, const T&). Inserting and erasing take O(log n)
+ * and no memory, the smallest element is cached. Equal elements are kept in
+ * the order they were inserted. The tree doesn't own the elements. */
+template<typename T, typename Less>
+class RBTree {
+public:
+	constexpr bool empty() const;
+
+	/* The smallest element, null if the tree is empty. */
+	constexpr T *first() const;
+	/* The element after elem, null if it's the last one. */
+	static constexpr T *next(const T& elem);
+
+	constexpr void insert(T& elem);
+	/* Remove an element that's in the tree. */
+	constexpr void erase(T& elem);
+
+private:
+	static constexpr bool is_red(const RBNode *node);
+	static constexpr RBNode *minimum(RBNode *node);
+	static constexpr RBNode *successor(const RBNode *node);
+
+	constexpr void replace_child(RBNode *parent, RBNode *old_child, RBNode *new_child);
+	constexpr void rotate_left(RBNode *node);
+	constexpr void rotate_right(RBNode *node);
+	constexpr void insert_fixup(RBNode *node);
+	constexpr void erase_fixup(RBNode *node, RBNode *parent);
+
+	RBNode *root = nullptr;
+	RBNode *leftmost = nullptr;
+	[[no_unique_address]] Less less {};
+};
+
+
+template<typename T, typename Less>
+constexpr bool RBTree<T, Less>::empty() const
+{
+	return !root;
+}
+
+template<typename T, typename Less>
+constexpr T *RBTree<T, Less>::first() const
+{
+	return static_cast<T *>(leftmost);
+}
+
+template<typename T, typename Less>
+constexpr T *RBTree<T, Less>::next(const T& elem)
+{
+	return static_cast<T *>(successor(&elem));
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::insert(T& elem)
+{
+	RBNode *node = &elem;
+	RBNode *parent = nullptr;
+	RBNode **link = &root;
+	bool is_leftmost = true;
+
+	// equal elements go right, after the ones already inserted
+	while (*link) {
+		parent = *link;
+		if (less(elem, *static_cast<T *>(parent))) {
+			link = &parent->left;
+		} else {
+			link = &parent->right;
+			is_leftmost = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = nullptr;
+	node->right = nullptr;
+	node->red = true;
+	*link = node;
+	if (is_leftmost)
+		leftmost = node;
+
+	insert_fixup(node);
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::erase(T& elem)
+{
+	RBNode *node = &elem;
+	if (node == leftmost)
+		leftmost = successor(node);
+
+	// child is the node taking the place of the one unlinked, and parent
+	// its new parent, as the child may be null
+	RBNode *child;
+	RBNode *parent;
+	bool unlinked_red = node->red;
+
+	if (!node->left || !node->right) {
+		child = node->left ? node->left : node->right;
+		parent = node->parent;
+		replace_child(parent, node, child);
+		if (child)
+			child->parent = parent;
+	} else {
+		// the successor has no left child, it's unlinked from its place
+		// and put into the one of node
+		RBNode *succ = minimum(node->right);
+		unlinked_red = succ->red;
+		child = succ->right;
+
+		if (succ->parent == node) {
+			parent = succ;
+		} else {
+			parent = succ->parent;
+			parent->left = child;
+			if (child)
+				child->parent = parent;
+			succ->right = node->right;
+			succ->right->parent = succ;
+		}
+
+		replace_child(node->parent, node, succ);
+		succ->parent = node->parent;
+		succ->left = node->left;
+		succ->left->parent = succ;
+		succ->red = node->red;
+	}
+
+	if (!unlinked_red)
+		erase_fixup(child, parent);
+}
+
+template<typename T, typename Less>
+constexpr bool RBTree<T, Less>::is_red(const RBNode *node)
+{
+	return node && node->red;
+}
+
+template<typename T, typename Less>
+constexpr RBNode *RBTree<T, Less>::minimum(RBNode *node)
+{
+	while (node->left)
+		node = node->left;
+	return node;
+}
+
+template<typename T, typename Less>
+constexpr RBNode *RBTree<T, Less>::successor(const RBNode *node)
+{
+	if (node->right)
+		return minimum(node->right);
+
+	RBNode *parent = node->parent;
+	while (parent && node == parent->right) {
+		node = parent;
+		parent = parent->parent;
+	}
+	return parent;
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::replace_child(RBNode *parent, RBNode *old_child,
+		RBNode *new_child)
+{
+	if (!parent)
+		root = new_child;
+	else if (parent->left == old_child)
+		parent->left = new_child;
+	else
+		parent->right = new_child;
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::rotate_left(RBNode *node)
+{
+	RBNode *right = node->right;
+	node->right = right->left;
+	if (right->left)
+		right->left->parent = node;
+	right->parent = node->parent;
+	replace_child(node->parent, node, right);
+	right->left = node;
+	node->parent = right;
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::rotate_right(RBNode *node)
+{
+	RBNode *left = node->left;
+	node->left = left->right;
+	if (left->right)
+		left->right->parent = node;
+	left->parent = node->parent;
+	replace_child(node->parent, node, left);
+	left->right = node;
+	node->parent = left;
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::insert_fixup(RBNode *node)
+{
+	// a red parent isn't the root, so there's a grandparent
+	while (is_red(node->parent)) {
+		RBNode *parent = node->parent;
+		RBNode *grandparent = parent->parent;
+
+		if (parent == grandparent->left) {
+			RBNode *uncle = grandparent->right;
+			if (is_red(uncle)) {
+				parent->red = false;
+				uncle->red = false;
+				grandparent->red = true;
+				node = grandparent;
+				continue;
+			}
+			if (node == parent->right) {
+				rotate_left(parent);
+				parent = node;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotate_right(grandparent);
+			break;
+		} else {
+			RBNode *uncle = grandparent->left;
+			if (is_red(uncle)) {
+				parent->red = false;
+				uncle->red = false;
+				grandparent->red = true;
+				node = grandparent;
+				continue;
+			}
+			if (node == parent->left) {
+				rotate_right(parent);
+				parent = node;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotate_left(grandparent);
+			break;
+		}
+	}
+	root->red = false;
+}
+
+template<typename T, typename Less>
+constexpr void RBTree<T, Less>::erase_fixup(RBNode *node, RBNode *parent)
+{
+	// node is short of a black node on its paths, its sibling can't be
+	// null as its paths have at least one
+	while (node != root && !is_red(node)) {
+		if (node == parent->left) {
+			RBNode *sibling = parent->right;
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_left(parent);
+				sibling = parent->right;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = true;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red(sibling->right)) {
+				sibling->left->red = false;
+				sibling->red = true;
+				rotate_right(sibling);
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->right->red = false;
+			rotate_left(parent);
+		} else {
+			RBNode *sibling = parent->left;
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_right(parent);
+				sibling = parent->left;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = true;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red(sibling->left)) {
+				sibling->right->red = false;
+				sibling->red = true;
+				rotate_left(sibling);
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->left->red = false;
+			rotate_right(parent);
+		}
+		node = root;
+	}
+	if (node)
+		node->red = false;
+}
+
+}
+
+#endif
@@ -29,6 +29,9 @@ template<typename T> struct RemoveReference 	 { typedef T Type; };
 template<typename T> struct RemoveReference<T&>  { typedef T Type; };
 template<typename T> struct RemoveReference<T&&> { typedef T Type; };
 
+/* Keeps template arguments from being deduced from a parameter. */
+template<typename T> struct TypeIdentity { typedef T Type; };
+
 template<class T> using UnderlyingType = __underlying_type(T);
 
 template<class T>
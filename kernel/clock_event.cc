@@ -0,0 +1,80 @@
+#include <kernel/clock_event.h>
+#include <kernel/irq.h>
+#include <kernel/ktime.h>
+#include <kernel/percpu.h>
+
+#include <kstd/algorithm.h>
+
+#include <arch/cpu.h>
+#include <arch/timer.h>
+
+
+namespace kernel {
+
+namespace {
+
+/* Deadlines further ahead are reached in steps, so converting them to
+ * cycles can't overflow. */
+constexpr uint64_t max_timer_delta = 3600 * nsec_per_sec;
+
+struct ClockEvent {
+	uint64_t deadline = no_deadline; /* Deadline the timer is programmed for. */
+};
+
+PerCPU<ClockEvent> clock_events;
+ClockEventHandler clock_event_handler = nullptr;
+
+void set_timer(uint64_t deadline)
+{
+	// only the time left is converted as the conversion error grows with
+	// it, and it's rounded up so the timer doesn't fire before it's over
+	const uint64_t cycles = arch::read_cycle_counter();
+	const uint64_t now = cycles_to_ktime(cycles);
+	const uint64_t delta = deadline > now ? kstd::min(deadline - now, max_timer_delta) : 0;
+	arch::set_timer_deadline(cycles + ns_to_cycles(delta) + 1);
+}
+
+void handle_timer()
+{
+	ClockEvent& event = clock_events.get();
+	if (event.deadline == no_deadline)
+		return;
+
+	// deadlines too far for the timer to reach fire early
+	const uint64_t now = ktime_get_ns();
+	if (now < event.deadline) {
+		set_timer(event.deadline);
+		return;
+	}
+
+	event.deadline = no_deadline;
+	if (!clock_event_handler)
+		return;
+	const uint64_t next = clock_event_handler(now);
+	if (next != no_deadline)
+		program_clock_event(next);
+}
+
+}
+
+bool setup_clock_event()
+{
+	return arch::setup_timer(handle_timer);
+}
+
+void set_clock_event_handler(ClockEventHandler handler)
+{
+	clock_event_handler = handler;
+}
+
+void program_clock_event(uint64_t deadline)
+{
+	IrqGuard irq_guard;
+	ClockEvent& event = clock_events.get();
+	if (deadline >= event.deadline)
+		return;
+	event.deadline = deadline;
+	set_timer(deadline);
+}
+
+}
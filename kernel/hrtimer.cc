@@ -0,0 +1,69 @@
+#include <kernel/hrtimer.h>
+#include <kernel/clock_event.h>
+#include <kernel/irq.h>
+#include <kernel/percpu.h>
+
+
+namespace kernel {
+
+namespace {
+
+struct ByExpiry {
+	bool operator()(const HrTimer& lhs, const HrTimer& rhs) const
+	{
+		return lhs.expires < rhs.expires;
+	}
+};
+
+using HrTimerQueue = kstd::RBTree<HrTimer, ByExpiry>;
+
+PerCPU<HrTimerQueue> hrtimer_queues;
+
+uint64_t run_hrtimers(uint64_t now)
+{
+	HrTimerQueue& queue = hrtimer_queues.get();
+	while (HrTimer *timer = queue.first()) {
+		if (timer->expires > now)
+			return timer->expires;
+		queue.erase(*timer);
+		timer->queued = false;
+		timer->callback(*timer);
+	}
+	return no_deadline;
+}
+
+}
+
+void setup_hrtimers()
+{
+	set_clock_event_handler(run_hrtimers);
+}
+
+void add_hrtimer(HrTimer& timer, uint64_t expires)
+{
+	IrqGuard irq_guard;
+	HrTimerQueue& queue = hrtimer_queues.get();
+	if (timer.queued)
+		queue.erase(timer);
+
+	timer.expires = expires;
+	timer.queued = true;
+	queue.insert(timer);
+	// only an earlier deadline is programmed, a later one is returned by
+	// run_hrtimers when the programmed one passes
+	if (queue.first() == &timer)
+		program_clock_event(expires);
+}
+
+bool cancel_hrtimer(HrTimer& timer)
+{
+	// the clock event stays programmed, firing finds nothing to run
+	IrqGuard irq_guard;
+	if (!timer.queued)
+		return false;
+	hrtimer_queues.get().erase(timer);
+	timer.queued = false;
+	return true;
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef _KERNEL__CLOCK_EVENT_H__
+#define _KERNEL__CLOCK_EVENT_H__
+
+#include <stdint.h>
+
+namespace kernel {
+
+/* The timer interrupt is tickless: it's programmed for the earliest deadline
+ * asked for and left off when there's none, so idle CPUs sleep until there's
+ * something to do. Deadlines are ktime values. */
+
+constexpr uint64_t no_deadline = UINT64_MAX;
+
+/* Run from the timer interrupt once the deadline passed, with interrupts
+ * disabled. Returns the next deadline or no_deadline. */
+using ClockEventHandler = uint64_t (*)(uint64_t now);
+
+/* Setup the timer of the current CPU, needs setup_ktime() first. Returns
+ * false if there's none. */
+bool setup_clock_event();
+
+void set_clock_event_handler(ClockEventHandler handler);
+
+/* Have the handler run on the current CPU once the deadline passes. Later
+ * deadlines than the programmed one are left to the handler to return. */
+void program_clock_event(uint64_t deadline);
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _KERNEL__HRTIMER_H__
+#define _KERNEL__HRTIMER_H__
+
+#include <stdint.h>
+
+#include <kstd/rbtree.h>
+
+namespace kernel {
+
+/* High-resolution timers fire at a ktime with the precision of the clock
+ * event, for the few timeouts the timer wheel tick is too coarse for. Each
+ * CPU keeps its pending ones in a red-black tree sorted by expiry, so adding
+ * and cancelling take O(log n) and the next one to fire is found in O(1).
+ * A timer is only touched on the CPU it was added on. */
+
+struct HrTimer;
+
+/* Run from the timer interrupt with interrupts disabled, the timer may be
+ * added again from it. */
+using HrTimerCallback = void (*)(HrTimer& timer);
+
+struct HrTimer : kstd::RBNode {
+	HrTimerCallback callback = nullptr;
+	uint64_t expires = 0; /* ktime the timer fires at. */
+	bool queued = false; /* Whether it's pending, set by the hrtimer code. */
+};
+
+/* Have the clock event run the hrtimers, needs setup_clock_event(). */
+void setup_hrtimers();
+
+/* Fire the timer on the current CPU at expires, moving it if it's already
+ * pending. An expiry already passed fires on the next timer interrupt. */
+void add_hrtimer(HrTimer& timer, uint64_t expires);
+
+/* Returns false if the timer wasn't pending. */
+bool cancel_hrtimer(HrTimer& timer);
+
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _KERNEL__IRQ_H__
+#define _KERNEL__IRQ_H__
+
+#include <arch/cpu.h>
+
+namespace kernel {
+
+/* Keep interrupts disabled on the current CPU for the lifetime of the guard. */
+class IrqGuard {
+public:
+	IrqGuard() : state(arch::irq_save()) {}
+
+	~IrqGuard()
+	{
+		arch::irq_restore(state);
+	}
+
+	IrqGuard(const IrqGuard&) = delete;
+	IrqGuard& operator=(const IrqGuard&) = delete;
+
+private:
+	arch::IrqState state;
+};
+
+}
+
+#endif
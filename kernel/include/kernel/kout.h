@@ -3,12 +3,13 @@
 
 #include <kstd/io.h>
 
-#include <arch/kout.h>
+#include <kernel/log.h>
 
 
 namespace kernel {
 
-using arch::kout;
+/* Kernel output stream, it writes into the log. */
+extern LogOStream kout;
 
 }
 
@@ -0,0 +1,33 @@
+#ifndef _KERNEL__KTIME_H__
+#define _KERNEL__KTIME_H__
+
+#include <stdint.h>
+
+namespace kernel {
+
+/* ktime is the monotonic time in nanoseconds since setup_ktime(), read from
+ * the cycle counter and converted with a multiply and a shift. */
+
+constexpr uint64_t nsec_per_usec = 1000;
+constexpr uint64_t nsec_per_msec = 1000 * nsec_per_usec;
+constexpr uint64_t nsec_per_sec = 1000 * nsec_per_msec;
+
+/* Find out the frequency of the cycle counter and start the clock. Returns
+ * false if it's unknown, ktime stays 0 then. */
+bool setup_ktime();
+
+/* Frequency of the cycle counter in Hz, 0 before setup_ktime(). */
+uint64_t get_ktime_frequency();
+
+uint64_t ktime_get_ns();
+
+/* ktime of a cycle counter value read on any CPU, e.g. a timestamp. */
+uint64_t cycles_to_ktime(uint64_t cycles);
+
+/* Convert durations, rounding down. */
+uint64_t cycles_to_ns(uint64_t cycles);
+uint64_t ns_to_cycles(uint64_t ns);
+
+}
+
+#endif
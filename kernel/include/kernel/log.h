@@ -0,0 +1,65 @@
+#ifndef _KERNEL__LOG_H__
+#define _KERNEL__LOG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kstd/io.h>
+
+namespace kernel {
+
+/* A line of the kernel log. */
+struct LogRecord {
+	uint64_t seq; /* Position of the line in the log of all CPUs. */
+	uint64_t timestamp; /* Cycle counter when the line was completed. */
+	unsigned int cpu; /* CPU the line was logged on. */
+	const char *text; /* Text of the line, not null-terminated. */
+	size_t len;
+};
+
+/* Destination of the log records, e.g. a console. */
+class LogSink {
+public:
+	virtual void emit(const LogRecord& record) = 0;
+
+protected:
+	~LogSink() = default;
+};
+
+/* Sink writing the text of the records to an output stream. */
+class OStreamLogSink final : public LogSink {
+public:
+	explicit OStreamLogSink(kstd::OStream& ostream) : ostream(ostream) {}
+
+	void emit(const LogRecord& record) override;
+
+private:
+	kstd::OStream& ostream;
+};
+
+/* Output stream writing into the log. Each CPU buffers its lines in RAM
+ * and nothing is written to a device until flush_log() hands them to the
+ * sinks. Writing takes no lock, the log of a CPU is only touched by that
+ * CPU with interrupts disabled and by the flushing CPU. */
+class LogOStream final : public kstd::OStream {
+public:
+	void putc(const char c) override;
+	void puts(const char *str) override;
+	void write(const char *str, size_t len) override;
+};
+
+/* Register a sink the log is flushed to.
+ * Returns false if there's no room left for it. */
+bool add_log_sink(LogSink& sink);
+
+/* Hand the complete lines logged so far to the sinks, in the order they
+ * were logged. Returns right away if another CPU is already flushing. */
+void flush_log();
+
+/* Same as flush_log() but for fatal errors, it doesn't give up on the lock
+ * held by a CPU flushing, which may be the one that crashed. */
+void flush_log_on_panic();
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef _KERNEL_MM__BUDDY_H__
+#define _KERNEL_MM__BUDDY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/memory.h>
+
+namespace kernel::mm {
+
+using arch::PhysAddr;
+
+/* Binary buddy allocator of physical page frames.
+ * Blocks of order k are 2^k frames large and aligned to their size.
+ * Free blocks are kept in per-order doubly linked lists stored inside the free
+ * frames themselves, and a per-order bitmap tells whether a block is free,
+ * so both allocation and freeing take O(max_order) steps.
+ * The allocator does no locking on its own. */
+class BuddyAllocator {
+public:
+	/* Largest block order, 2^18 frames is 1Gb. */
+	static constexpr unsigned int max_order = 18;
+	static constexpr unsigned int nr_orders = max_order + 1;
+
+	/* Number of bytes of bitmap memory needed to manage the physical memory [beg, end). */
+	static size_t get_bitmap_size(PhysAddr beg, PhysAddr end);
+
+	/* Start managing the physical memory [beg, end) with no free frames in it.
+	 * The bitmap should point to get_bitmap_size(beg, end) zeroed bytes. */
+	void init(PhysAddr beg, PhysAddr end, void *bitmap);
+
+	/* Give the frames of the physical memory [beg, end) to the allocator.
+	 * The range should be within the managed memory and not given twice. */
+	void add_free_memory(PhysAddr beg, PhysAddr end);
+
+	/* Allocate 2^order contiguous frames. Returns 0 if there's no free block large enough. */
+	PhysAddr alloc(unsigned int order);
+	/* Free the 2^order frames previously allocated at addr. */
+	void free(PhysAddr addr, unsigned int order);
+
+	/* Number of free frames. */
+	size_t get_nr_free_frames() const;
+
+private:
+	/* Free block header living in the first frame of the block. */
+	struct FreeBlock {
+		FreeBlock *prev;
+		FreeBlock *next;
+	};
+
+	using BitmapWord = uint64_t;
+	static constexpr unsigned int bitmap_word_bits = sizeof(BitmapWord) * 8;
+
+	/* Number of blocks of the given order in the managed memory. */
+	static size_t get_nr_blocks(size_t nr_frames, unsigned int order);
+
+	size_t get_block_idx(PhysAddr addr, unsigned int order) const;
+	bool test_free(size_t idx, unsigned int order) const;
+	void switch_free(size_t idx, unsigned int order);
+
+	void push_free_block(PhysAddr addr, unsigned int order);
+	void remove_free_block(PhysAddr addr, unsigned int order);
+	PhysAddr pop_free_block(unsigned int order);
+
+	PhysAddr base = 0; /* Beginning of the managed memory aligned to the largest block. */
+	size_t nr_frames = 0; /* Number of frames in the managed memory starting from base. */
+	size_t nr_free_frames = 0;
+
+	FreeBlock *free_lists[nr_orders] {};
+	BitmapWord *free_bitmaps[nr_orders] {};
+	/* Bit k is set if the free list of order k is not empty. */
+	uint32_t nonempty_orders = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _KERNEL_MM__FRAME_H__
+#define _KERNEL_MM__FRAME_H__
+
+#include <stddef.h>
+
+#include <arch/memory.h>
+
+#include <kstd/enum.h>
+
+namespace kernel::mm {
+
+using arch::PhysAddr;
+
+enum class FrameFlags {
+	None = 0x0,
+	/* The frame is not expected to be in the CPU cache: when allocating, the
+	 * caller will not read it soon, when freeing, its contents weren't touched lately. */
+	Cold = 0x1,
+};
+KSTD_DEFINE_ENUM_LOGIC_BITWISE_OPERATORS(FrameFlags);
+
+/* Setup the physical frame allocator from the memory left free after boot. */
+void setup_frame_allocator();
+
+/* Allocate 2^order physically contiguous frames. Returns 0 on failure.
+ * Single frames come from a CPU-local cache and don't touch the global pool
+ * most of the time. */
+PhysAddr alloc_frames(unsigned int order = 0, FrameFlags flags = FrameFlags::None);
+/* Free 2^order frames allocated with alloc_frames. */
+void free_frames(PhysAddr addr, unsigned int order = 0, FrameFlags flags = FrameFlags::None);
+
+/* Return the single frames cached by the current CPU to the global pool. */
+void drain_frame_cache();
+
+/* Number of free frames. */
+size_t get_nr_free_frames();
+
+}
+
+#endif
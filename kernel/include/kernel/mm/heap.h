@@ -0,0 +1,24 @@
+#ifndef _KERNEL_MM__HEAP_H__
+#define _KERNEL_MM__HEAP_H__
+
+#include <stddef.h>
+
+namespace kernel::mm {
+
+/* Alignment of heap allocations when none is specified, same as of operator new. */
+constexpr size_t default_heap_align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+/* Setup the kernel heap. The frame allocator should be set up before. */
+void setup_heap();
+
+/* Allocate size bytes aligned to align, which must be a power of 2
+ * less than slab_size. Returns nullptr if out of memory.
+ * Sizes up to a page are served by per size class slab caches,
+ * larger ones by frame blocks directly. */
+void *kmalloc(size_t size, size_t align = default_heap_align);
+/* Free memory allocated with kmalloc. */
+void kfree(void *ptr);
+
+}
+
+#endif
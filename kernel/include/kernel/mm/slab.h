@@ -0,0 +1,130 @@
+#ifndef _KERNEL_MM__SLAB_H__
+#define _KERNEL_MM__SLAB_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/cpu.h>
+#include <arch/memory.h>
+
+#include <kernel/percpu.h>
+#include <kernel/spinlock.h>
+
+namespace kernel::mm {
+
+class SlabCache;
+
+/* Header at the beginning of every slab and of every large heap allocation.
+ * Slabs are slab_size large and aligned, so the header of any object can be
+ * found by aligning the object address down to slab_size. */
+struct SlabHeader {
+	SlabCache *cache; /* Owning cache, nullptr for large allocations. */
+	unsigned int order; /* Order of the frame block the memory lies in. */
+};
+
+/* Order of the frame block of a slab. */
+constexpr unsigned int slab_order = 3;
+constexpr unsigned int slab_size_shift = arch::page_size_shift + slab_order;
+constexpr size_t slab_size = size_t(1) << slab_size_shift;
+
+/* Get the header of the slab or the large allocation the pointer belongs to. */
+inline SlabHeader *get_slab_header(const void *ptr)
+{
+	return reinterpret_cast<SlabHeader *>(
+			reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(slab_size - 1));
+}
+
+/* Cache of equally sized objects carved out of slabs.
+ * Each CPU keeps a magazine of free objects in front of the slabs, so
+ * allocating and freeing usually touch only CPU-local data. The slabs
+ * themselves are shared and protected by a spinlock. */
+class SlabCache {
+public:
+	/* Setup the cache for objects of the given size. */
+	void init(size_t object_size);
+
+	/* Allocate an object. Returns nullptr if out of memory. */
+	void *alloc();
+	/* Free an object allocated from this cache. */
+	void free(void *ptr);
+
+	size_t get_object_size() const
+	{
+		return object_size;
+	}
+
+	/* Alignment every object of the cache is guaranteed to have. */
+	size_t get_object_align() const
+	{
+		return object_align;
+	}
+
+	/* Alignment guaranteed for objects of the given size. Objects are
+	 * aligned to the largest power of 2 dividing their size, up to a page. */
+	static constexpr size_t get_object_align(size_t object_size)
+	{
+		size_t align = object_size & -object_size;
+		return align < arch::page_size ? align : arch::page_size;
+	}
+
+private:
+	/* Free object, linked into the free list of its slab. */
+	struct FreeObject {
+		FreeObject *next;
+	};
+
+	struct Slab : SlabHeader {
+		Slab *prev;
+		Slab *next;
+		FreeObject *free_objects;
+		unsigned int nr_used;
+	};
+
+	/* CPU-local stack of free objects. */
+	struct Magazine {
+		static constexpr unsigned int capacity = 16;
+
+		unsigned int nr_objects = 0;
+		void *objects[capacity] {};
+	};
+
+	static constexpr size_t get_objects_offset(size_t object_size)
+	{
+		const size_t align = get_object_align(object_size);
+		// the first object of a cache line or larger starts a cache
+		// line, the next ones only do if the size is a multiple of it
+		const size_t min_align = object_size < arch::cache_line_size
+			? align : arch::cache_line_size;
+		const size_t offset_align = align > min_align ? align : min_align;
+		return (sizeof(Slab) + offset_align - 1) & ~(offset_align - 1);
+	}
+
+	/* Move up to nr objects from the slabs into the magazine. */
+	void refill(Magazine& magazine, unsigned int nr);
+	/* Move the nr topmost objects of the magazine back to their slabs. */
+	void drain(Magazine& magazine, unsigned int nr);
+
+	void *alloc_from_slabs();
+	void free_to_slab(void *ptr);
+
+	Slab *create_slab();
+
+	static void link_slab(Slab *&list, Slab *slab);
+	static void unlink_slab(Slab *&list, Slab *slab);
+
+	size_t object_size = 0;
+	size_t object_align = 0;
+	size_t objects_offset = 0;
+	unsigned int nr_objects_per_slab = 0;
+
+	SpinLock lock;
+	Slab *partial_slabs = nullptr; /* Slabs with both used and free objects. */
+	Slab *free_slabs = nullptr; /* Slabs with only free objects. */
+	unsigned int nr_free_slabs = 0;
+
+	PerCPU<Magazine> magazines;
+};
+
+}
+
+#endif
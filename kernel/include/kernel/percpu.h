@@ -0,0 +1,40 @@
+#ifndef _KERNEL__PERCPU_H__
+#define _KERNEL__PERCPU_H__
+
+#include <config.h>
+
+#include <arch/cpu.h>
+
+namespace kernel {
+
+constexpr unsigned int max_nr_cpus = CONFIG_MAX_CPUS;
+
+/* An instance of T for each CPU. Instances are kept in separate cache lines
+ * so CPUs never share lines when touching their own instance.
+ * The current CPU's instance should only be accessed with interrupts disabled. */
+template<typename T>
+class PerCPU {
+public:
+	/* Get the instance of the current CPU. */
+	T& get()
+	{
+		return get(arch::get_cpu_id());
+	}
+
+	/* Get the instance of the given CPU. */
+	T& get(unsigned int cpu)
+	{
+		return slots[cpu].value;
+	}
+
+private:
+	struct alignas(arch::cache_line_size) Slot {
+		T value;
+	};
+
+	Slot slots[max_nr_cpus] {};
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _KERNEL__SPINLOCK_H__
+#define _KERNEL__SPINLOCK_H__
+
+#include <arch/cpu.h>
+
+namespace kernel {
+
+/* Test-and-test-and-set spinlock. */
+class SpinLock {
+public:
+	void lock()
+	{
+		while (__atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE)) {
+			// spin on a plain load to keep the cache line shared
+			while (__atomic_load_n(&locked, __ATOMIC_RELAXED))
+				arch::cpu_relax();
+		}
+	}
+
+	bool try_lock()
+	{
+		return !__atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE);
+	}
+
+	void unlock()
+	{
+		__atomic_store_n(&locked, false, __ATOMIC_RELEASE);
+	}
+
+private:
+	bool locked = false;
+};
+
+/* Lock the spinlock for the lifetime of the guard. */
+template<typename Lock>
+class LockGuard {
+public:
+	explicit LockGuard(Lock& lock) : lock(lock)
+	{
+		lock.lock();
+	}
+
+	~LockGuard()
+	{
+		lock.unlock();
+	}
+
+	LockGuard(const LockGuard&) = delete;
+	LockGuard& operator=(const LockGuard&) = delete;
+
+private:
+	Lock& lock;
+};
+
+}
+
+#endif
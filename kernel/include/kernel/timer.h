@@ -0,0 +1,50 @@
+#ifndef _KERNEL__TIMER_H__
+#define _KERNEL__TIMER_H__
+
+#include <stdint.h>
+
+#include <kernel/ktime.h>
+
+namespace kernel {
+
+/* Timers for the bulk of the timeouts, which don't mind firing up to a tick
+ * late. Each CPU keeps its pending ones in a hierarchical timing wheel: the
+ * first level has a list for each of the next 256 ticks, the following ones
+ * have 64 lists each 64 times coarser. Adding and cancelling take O(1), a
+ * list of a coarser level is cascaded into the finer ones once its time
+ * comes. The wheel is driven by an hrtimer programmed for the next tick
+ * with something to do, there's no periodic tick.
+ * A timer is only touched on the CPU it was added on. */
+
+constexpr uint64_t timer_tick_ns = nsec_per_msec;
+
+struct Timer;
+
+/* Run from the timer interrupt with interrupts disabled, the timer may be
+ * added again from it. */
+using TimerCallback = void (*)(Timer& timer);
+
+struct Timer {
+	TimerCallback callback = nullptr;
+	uint64_t expires = 0; /* ktime the timer fires after. */
+
+	/* Set by the timer code. */
+	uint64_t expires_tick = 0;
+	Timer *next = nullptr;
+	Timer **pprev = nullptr; /* Link pointing to the timer, null if it's not pending. */
+	uint16_t slot = 0;
+};
+
+/* Setup the timer wheel of the current CPU, needs setup_hrtimers(). */
+void setup_timers();
+
+/* Fire the timer on the current CPU on the first tick at or after expires,
+ * moving it if it's already pending. */
+void add_timer(Timer& timer, uint64_t expires);
+
+/* Returns false if the timer wasn't pending. */
+bool cancel_timer(Timer& timer);
+
+}
+
+#endif
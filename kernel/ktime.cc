@@ -0,0 +1,80 @@
+#include <kernel/ktime.h>
+
+#include <arch/cpu.h>
+
+
+namespace kernel {
+
+namespace {
+
+/* Conversion of a count at one frequency into a count at another one,
+ * value * mult >> shift. */
+struct Conversion {
+	uint32_t mult = 0;
+	unsigned int shift = 0;
+
+	uint64_t apply(uint64_t value) const
+	{
+		// both halves are multiplied on their own, so a 64bit value
+		// can't overflow before the shift
+		const uint64_t low = (value & UINT32_MAX) * mult >> shift;
+		const uint64_t high = (value >> 32) * mult << (32 - shift);
+		return high + low;
+	}
+};
+
+/* The most precise conversion from frequency from to frequency to. */
+Conversion make_conversion(uint64_t from, uint64_t to)
+{
+	unsigned int shift = 32;
+	while (shift && (to > UINT64_MAX >> shift || (to << shift) / from > UINT32_MAX))
+		--shift;
+	return {uint32_t((to << shift) / from), shift};
+}
+
+uint64_t frequency = 0;
+uint64_t start_cycles = 0;
+Conversion cycles_to_ns_conv;
+Conversion ns_to_cycles_conv;
+
+}
+
+bool setup_ktime()
+{
+	frequency = arch::get_cycle_counter_frequency();
+	if (!frequency)
+		return false;
+
+	cycles_to_ns_conv = make_conversion(frequency, nsec_per_sec);
+	ns_to_cycles_conv = make_conversion(nsec_per_sec, frequency);
+	start_cycles = arch::read_cycle_counter();
+	return true;
+}
+
+uint64_t get_ktime_frequency()
+{
+	return frequency;
+}
+
+uint64_t ktime_get_ns()
+{
+	return cycles_to_ktime(arch::read_cycle_counter());
+}
+
+uint64_t cycles_to_ktime(uint64_t cycles)
+{
+	// the counters of other CPUs may be slightly behind
+	return cycles > start_cycles ? cycles_to_ns(cycles - start_cycles) : 0;
+}
+
+uint64_t cycles_to_ns(uint64_t cycles)
+{
+	return cycles_to_ns_conv.apply(cycles);
+}
+
+uint64_t ns_to_cycles(uint64_t ns)
+{
+	return ns_to_cycles_conv.apply(ns);
+}
+
+}
@@ -0,0 +1,254 @@
+#include <kernel/log.h>
+#include <kernel/kout.h>
+#include <kernel/percpu.h>
+#include <kernel/irq.h>
+#include <kernel/spinlock.h>
+
+#include <arch/cpu.h>
+
+#include <string.h>
+
+
+namespace kernel {
+
+LogOStream kout;
+
+namespace {
+
+/* Header in front of the text of every record in a ring. */
+struct RecordHeader {
+	uint64_t seq;
+	uint64_t timestamp;
+	size_t len;
+};
+
+constexpr size_t max_line_len = 256;
+constexpr unsigned int max_nr_sinks = 4;
+/* Spins flush_log_on_panic() waits for the lock before taking it over. */
+constexpr unsigned long panic_lock_spins = 1 << 24;
+
+uint64_t next_seq = 0;
+/* Lines lost to full rings, and how many of them were reported. */
+unsigned long nr_dropped = 0;
+unsigned long nr_dropped_reported = 0;
+
+/* Records of a CPU. Only the CPU itself writes them and only the flushing
+ * CPU reads them, head and tail are the only state they share. */
+class LogRing {
+public:
+	static constexpr size_t size = 4096;
+	static_assert(!(size & (size - 1)), "the ring size must be a power of 2");
+
+	/* Append text to the current line, completed lines become records. */
+	void write(const char *str, size_t len);
+
+	/* Get the header of the oldest record, if there's one. */
+	bool peek(RecordHeader& header) const;
+	/* Copy the text of the oldest record and remove it. */
+	void pop(const RecordHeader& header, char *text);
+
+private:
+	void commit_line();
+	void copy_in(size_t pos, const void *src, size_t len);
+	void copy_out(void *dst, size_t pos, size_t len) const;
+
+	char buffer[size];
+	size_t head; /* Moved by the owner CPU. */
+	size_t tail; /* Moved by the flushing CPU. */
+	char line[max_line_len];
+	size_t line_len;
+};
+
+void LogRing::write(const char *str, size_t len)
+{
+	while (len) {
+		const auto *newline = static_cast<const char *>(memchr(str, '\n', len));
+		size_t chunk = newline ? newline - str + 1 : len;
+		if (chunk > max_line_len - line_len)
+			chunk = max_line_len - line_len;
+
+		memcpy(line + line_len, str, chunk);
+		line_len += chunk;
+		str += chunk;
+		len -= chunk;
+
+		// lines too long for the buffer are split
+		if (line[line_len - 1] == '\n' || line_len == max_line_len)
+			commit_line();
+	}
+}
+
+void LogRing::commit_line()
+{
+	const RecordHeader header = {
+		.seq = __atomic_fetch_add(&next_seq, 1, __ATOMIC_RELAXED),
+		.timestamp = arch::read_cycle_counter(),
+		.len = line_len,
+	};
+	line_len = 0;
+
+	const size_t record_size = sizeof(header) + header.len;
+	if (size - (head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) < record_size) {
+		__atomic_fetch_add(&nr_dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	copy_in(head, &header, sizeof(header));
+	copy_in(head + sizeof(header), line, header.len);
+	__atomic_store_n(&head, head + record_size, __ATOMIC_RELEASE);
+}
+
+bool LogRing::peek(RecordHeader& header) const
+{
+	if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == tail)
+		return false;
+	copy_out(&header, tail, sizeof(header));
+	return true;
+}
+
+void LogRing::pop(const RecordHeader& header, char *text)
+{
+	copy_out(text, tail + sizeof(header), header.len);
+	__atomic_store_n(&tail, tail + sizeof(header) + header.len, __ATOMIC_RELEASE);
+}
+
+void LogRing::copy_in(size_t pos, const void *src, size_t len)
+{
+	const size_t offset = pos & (size - 1);
+	const size_t first = len < size - offset ? len : size - offset;
+	memcpy(buffer + offset, src, first);
+	memcpy(buffer, static_cast<const char *>(src) + first, len - first);
+}
+
+void LogRing::copy_out(void *dst, size_t pos, size_t len) const
+{
+	const size_t offset = pos & (size - 1);
+	const size_t first = len < size - offset ? len : size - offset;
+	memcpy(dst, buffer + offset, first);
+	memcpy(static_cast<char *>(dst) + first, buffer, len - first);
+}
+
+PerCPU<LogRing> rings;
+
+SpinLock flush_lock;
+LogSink *sinks[max_nr_sinks];
+unsigned int nr_sinks = 0;
+
+void emit(const LogRecord& record)
+{
+	for (unsigned int i = 0; i < nr_sinks; ++i)
+		sinks[i]->emit(record);
+}
+
+void report_dropped()
+{
+	const unsigned long dropped = __atomic_load_n(&nr_dropped, __ATOMIC_RELAXED);
+	if (dropped == nr_dropped_reported)
+		return;
+
+	char text[64] = "<log lines dropped: ";
+	const size_t prefix_len = strlen(text);
+	char digits[24];
+	char *const digits_end = digits + sizeof(digits);
+	const char *const digits_start =
+		klibc::format_dec(digits_end, dropped - nr_dropped_reported);
+	const size_t nr_digits = digits_end - digits_start;
+	memcpy(text + prefix_len, digits_start, nr_digits);
+	memcpy(text + prefix_len + nr_digits, ">\n", 2);
+	nr_dropped_reported = dropped;
+
+	emit({
+		.seq = __atomic_load_n(&next_seq, __ATOMIC_RELAXED),
+		.timestamp = arch::read_cycle_counter(),
+		.cpu = arch::get_cpu_id(),
+		.text = text,
+		.len = prefix_len + nr_digits + 2,
+	});
+}
+
+/* Hand the records to the sinks, with flush_lock held. */
+void flush_locked()
+{
+	while (true) {
+		// the CPUs log concurrently, their oldest records are merged
+		LogRing *oldest_ring = nullptr;
+		unsigned int oldest_cpu = 0;
+		RecordHeader oldest;
+		for (unsigned int cpu = 0; cpu < max_nr_cpus; ++cpu) {
+			RecordHeader header;
+			LogRing& ring = rings.get(cpu);
+			if (ring.peek(header) && (!oldest_ring || header.seq < oldest.seq)) {
+				oldest_ring = &ring;
+				oldest_cpu = cpu;
+				oldest = header;
+			}
+		}
+		if (!oldest_ring)
+			break;
+
+		char text[max_line_len];
+		oldest_ring->pop(oldest, text);
+		emit({
+			.seq = oldest.seq,
+			.timestamp = oldest.timestamp,
+			.cpu = oldest_cpu,
+			.text = text,
+			.len = oldest.len,
+		});
+	}
+	report_dropped();
+}
+
+}
+
+void OStreamLogSink::emit(const LogRecord& record)
+{
+	ostream.write(record.text, record.len);
+}
+
+void LogOStream::putc(const char c)
+{
+	write(&c, 1);
+}
+
+void LogOStream::puts(const char *str)
+{
+	write(str, strlen(str));
+}
+
+void LogOStream::write(const char *str, size_t len)
+{
+	IrqGuard irq_guard;
+	rings.get().write(str, len);
+}
+
+bool add_log_sink(LogSink& sink)
+{
+	LockGuard guard(flush_lock);
+	if (nr_sinks == max_nr_sinks)
+		return false;
+	sinks[nr_sinks++] = &sink;
+	return true;
+}
+
+void flush_log()
+{
+	if (!flush_lock.try_lock())
+		return;
+	flush_locked();
+	flush_lock.unlock();
+}
+
+void flush_log_on_panic()
+{
+	// a lock held for longer than a flush takes is taken over
+	for (unsigned long i = 0; i < panic_lock_spins; ++i) {
+		if (flush_lock.try_lock())
+			break;
+		arch::cpu_relax();
+	}
+	flush_locked();
+	flush_lock.unlock();
+}
+
+}
@@ -1,17 +1,76 @@
 #include <kernel/runtime.h>
+#include <kernel/clock_event.h>
+#include <kernel/hrtimer.h>
+#include <kernel/ktime.h>
 #include <kernel/kout.h>
+#include <kernel/timer.h>
+#include <kernel/mm/frame.h>
+#include <kernel/mm/heap.h>
+
+#include <kstd/format.h>
 
 #include <arch/boot/setup.h>
+#include <arch/kout.h>
+#include <arch/cpu.h>
+#include <arch/interrupts.h>
+#include <arch/paging.h>
 
 namespace kernel {
 
+static OStreamLogSink console_sink(arch::kout);
+
+/* Run when there's nothing else to do. */
+[[noreturn]] static void idle()
+{
+	while (true) {
+		// the consoles are written here rather than by the code logging
+		flush_log();
+		// use the spare time to get work out of the way of later mappings
+		while (arch::prepare_page_table())
+			;
+		// the timer is only programmed for pending deadlines, an idle
+		// CPU isn't woken up periodically
+		arch::wait_for_interrupt();
+	}
+}
+
 extern "C" __attribute__((section(".text")))
 void main(arch::BootInfo *boot_info)
 {
 	static_init();
 	arch::setup(boot_info);
+	add_log_sink(console_sink);
+	// the log is only flushed when idle, crashes flush it themselves
+	arch::set_panic_handler(flush_log_on_panic);
 	kout << "\033c\033[3m" << "Successfully entered the main() entry.\n";
-	asm volatile ("hlt");
+
+	const arch::InterruptCost irq_cost = arch::measure_interrupt_cost(1000);
+	kstd::print(kout, "Interrupt entry and exit: {} cycles min, {} cycles avg\n",
+			irq_cost.min_cycles, irq_cost.avg_cycles);
+	const bool has_clock = setup_ktime();
+	if (has_clock)
+		kstd::print(kout, "Clock: {} kHz cycle counter{}\n", get_ktime_frequency() / 1000,
+				arch::is_cycle_counter_invariant() ? "" : ", not invariant");
+	else
+		kout << "No clock found.\n";
+	arch::irq_enable();
+
+	mm::setup_frame_allocator();
+	arch::setup_paging(
+		[]() { return mm::alloc_frames(); },
+		[](arch::PhysAddr frame) { mm::free_frames(frame); });
+	if (!arch::setup_interrupt_controller()) {
+		kout << "No interrupt controller found.\n";
+	} else if (has_clock && setup_clock_event()) {
+		setup_hrtimers();
+		setup_timers();
+	} else if (has_clock) {
+		kout << "No timer found.\n";
+	}
+	mm::setup_heap();
+	kstd::print(kout, "Free memory: {} KiB\n",
+			mm::get_nr_free_frames() << arch::page_size_shift >> 10);
+	idle();
 }
 
 }
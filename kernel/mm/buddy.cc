@@ -0,0 +1,162 @@
+#include <kernel/mm/buddy.h>
+
+#include <kstd/algorithm.h>
+#include <kstd/memory.h>
+
+
+namespace kernel::mm {
+
+using arch::page_size_shift;
+
+size_t BuddyAllocator::get_bitmap_size(PhysAddr beg, PhysAddr end)
+{
+	beg = kstd::align_floored(beg, page_size_shift + max_order);
+	const size_t nr_frames = (end - beg) >> page_size_shift;
+
+	size_t nr_words = 0;
+	for (unsigned int order = 0; order < nr_orders; ++order)
+		nr_words += (get_nr_blocks(nr_frames, order) + bitmap_word_bits - 1)
+			/ bitmap_word_bits;
+	return nr_words * sizeof(BitmapWord);
+}
+
+void BuddyAllocator::init(PhysAddr beg, PhysAddr end, void *bitmap)
+{
+	// aligning the base to the largest block lets buddies be found by
+	// flipping a single bit of the block address
+	base = kstd::align_floored(beg, page_size_shift + max_order);
+	nr_frames = (end - base) >> page_size_shift;
+	nr_free_frames = 0;
+	nonempty_orders = 0;
+
+	auto *words = static_cast<BitmapWord *>(bitmap);
+	for (unsigned int order = 0; order < nr_orders; ++order) {
+		free_lists[order] = nullptr;
+		free_bitmaps[order] = words;
+		words += (get_nr_blocks(nr_frames, order) + bitmap_word_bits - 1)
+			/ bitmap_word_bits;
+	}
+}
+
+void BuddyAllocator::add_free_memory(PhysAddr beg, PhysAddr end)
+{
+	beg = kstd::align_ceiled(beg, page_size_shift);
+	end = kstd::align_floored(end, page_size_shift);
+
+	while (beg < end) {
+		// the largest block that is aligned to beg and fits before end
+		const PhysAddr frame_n = beg >> page_size_shift;
+		unsigned int order = frame_n ? __builtin_ctzll(frame_n) : max_order;
+		order = kstd::min(order, max_order);
+		while ((PhysAddr(1) << (order + page_size_shift)) > end - beg)
+			--order;
+
+		free(beg, order);
+		beg += PhysAddr(1) << (order + page_size_shift);
+	}
+}
+
+PhysAddr BuddyAllocator::alloc(unsigned int order)
+{
+	if (order > max_order) [[unlikely]]
+		return 0;
+
+	// the smallest nonempty order not less than the requested one
+	const uint32_t candidates = nonempty_orders & ~((uint32_t(1) << order) - 1);
+	if (!candidates)
+		return 0;
+	unsigned int curr_order = __builtin_ctz(candidates);
+
+	const PhysAddr addr = pop_free_block(curr_order);
+
+	// split the block giving the upper halves back
+	while (curr_order > order) {
+		--curr_order;
+		push_free_block(addr + (PhysAddr(1) << (curr_order + page_size_shift)), curr_order);
+	}
+
+	nr_free_frames -= size_t(1) << order;
+	return addr;
+}
+
+void BuddyAllocator::free(PhysAddr addr, unsigned int order)
+{
+	nr_free_frames += size_t(1) << order;
+
+	// merge with the buddy as long as it's free too
+	while (order < max_order) {
+		const size_t buddy_idx = get_block_idx(addr, order) ^ 1;
+		if (buddy_idx >= get_nr_blocks(nr_frames, order) || !test_free(buddy_idx, order))
+			break;
+
+		const PhysAddr buddy_addr = addr ^ (PhysAddr(1) << (order + page_size_shift));
+		remove_free_block(buddy_addr, order);
+		addr = kstd::min(addr, buddy_addr);
+		++order;
+	}
+
+	push_free_block(addr, order);
+}
+
+size_t BuddyAllocator::get_nr_free_frames() const
+{
+	return nr_free_frames;
+}
+
+
+size_t BuddyAllocator::get_nr_blocks(size_t nr_frames, unsigned int order)
+{
+	return nr_frames >> order;
+}
+
+size_t BuddyAllocator::get_block_idx(PhysAddr addr, unsigned int order) const
+{
+	return (addr - base) >> (page_size_shift + order);
+}
+
+bool BuddyAllocator::test_free(size_t idx, unsigned int order) const
+{
+	return (free_bitmaps[order][idx / bitmap_word_bits] >> (idx % bitmap_word_bits)) & 1;
+}
+
+void BuddyAllocator::switch_free(size_t idx, unsigned int order)
+{
+	free_bitmaps[order][idx / bitmap_word_bits] ^= BitmapWord(1) << (idx % bitmap_word_bits);
+}
+
+void BuddyAllocator::push_free_block(PhysAddr addr, unsigned int order)
+{
+	auto *block = static_cast<FreeBlock *>(arch::phys_to_virt(addr));
+	block->prev = nullptr;
+	block->next = free_lists[order];
+	if (block->next)
+		block->next->prev = block;
+	free_lists[order] = block;
+
+	switch_free(get_block_idx(addr, order), order);
+	nonempty_orders |= uint32_t(1) << order;
+}
+
+void BuddyAllocator::remove_free_block(PhysAddr addr, unsigned int order)
+{
+	auto *block = static_cast<FreeBlock *>(arch::phys_to_virt(addr));
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		free_lists[order] = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+
+	switch_free(get_block_idx(addr, order), order);
+	if (!free_lists[order])
+		nonempty_orders &= ~(uint32_t(1) << order);
+}
+
+PhysAddr BuddyAllocator::pop_free_block(unsigned int order)
+{
+	const PhysAddr addr = arch::virt_to_phys(free_lists[order]);
+	remove_free_block(addr, order);
+	return addr;
+}
+
+}
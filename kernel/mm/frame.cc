@@ -0,0 +1,222 @@
+#include <kernel/mm/frame.h>
+#include <kernel/mm/buddy.h>
+#include <kernel/spinlock.h>
+#include <kernel/percpu.h>
+#include <kernel/irq.h>
+
+#include <arch/boot/setup.h>
+
+#include <kstd/algorithm.h>
+#include <kstd/memory.h>
+
+#include <string.h>
+
+
+namespace kernel::mm {
+
+using arch::page_size_shift;
+using arch::PhysSize;
+
+static BuddyAllocator buddy;
+/* Taken with interrupts disabled, the frame caches refill and drain from
+ * interrupt handlers too. */
+static SpinLock buddy_lock;
+
+/* CPU-local ring of free single frames. Hot frames, the ones likely to still be
+ * in the CPU cache, are pushed and popped at the head, cold ones at the tail.
+ * The global pool is only touched to move whole batches in and out. */
+class FrameCache {
+public:
+	static constexpr unsigned int capacity = 64;
+	/* Number of frames moved between the cache and the global pool at once. */
+	static constexpr unsigned int batch_size = 16;
+
+	static_assert((capacity & (capacity - 1)) == 0, "Capacity must be a power of 2.");
+	static_assert(batch_size <= capacity);
+
+	bool empty() const
+	{
+		return nr_frames == 0;
+	}
+
+	bool full() const
+	{
+		return nr_frames == capacity;
+	}
+
+	unsigned int size() const
+	{
+		return nr_frames;
+	}
+
+	void push_hot(PhysAddr addr)
+	{
+		frames[(tail + nr_frames++) & mask] = addr;
+	}
+
+	PhysAddr pop_hot()
+	{
+		return frames[(tail + --nr_frames) & mask];
+	}
+
+	void push_cold(PhysAddr addr)
+	{
+		tail = (tail - 1) & mask;
+		frames[tail] = addr;
+		++nr_frames;
+	}
+
+	PhysAddr pop_cold()
+	{
+		const PhysAddr addr = frames[tail];
+		tail = (tail + 1) & mask;
+		--nr_frames;
+		return addr;
+	}
+
+	/* Take up to batch_size frames from the global pool. */
+	void refill()
+	{
+		LockGuard guard(buddy_lock);
+		for (unsigned int i = 0; i < batch_size; ++i) {
+			const PhysAddr addr = buddy.alloc(0);
+			if (!addr)
+				break;
+			push_cold(addr);
+		}
+	}
+
+	/* Give the nr coldest frames back to the global pool. */
+	void drain(unsigned int nr)
+	{
+		LockGuard guard(buddy_lock);
+		for (unsigned int i = 0; i < nr; ++i)
+			buddy.free(pop_cold(), 0);
+	}
+
+private:
+	static constexpr unsigned int mask = capacity - 1;
+
+	PhysAddr frames[capacity];
+	unsigned int tail = 0; /* Index of the coldest frame. */
+	unsigned int nr_frames = 0;
+};
+
+static PerCPU<FrameCache> frame_caches;
+
+/* Get the page aligned part of a free memory entry.
+ * Returns false if there's nothing usable left. */
+static bool get_usable_range(const arch::PhysicalMMap::Entry& entry,
+		PhysAddr& beg, PhysAddr& end)
+{
+	beg = kstd::align_ceiled((PhysAddr)entry.base_addr, page_size_shift);
+	end = kstd::align_floored((PhysAddr)(entry.base_addr + entry.length), page_size_shift);
+	return beg < end;
+}
+
+void setup_frame_allocator()
+{
+	const arch::PhysicalMMap mmap = arch::get_free_physical_mmap();
+
+	// find the span of the usable memory
+	PhysAddr span_beg = ~PhysAddr(0), span_end = 0;
+	for (size_t i = 0; i < mmap.nr_entries; ++i) {
+		PhysAddr beg, end;
+		if (!get_usable_range(mmap.entries[i], beg, end))
+			continue;
+		span_beg = kstd::min(span_beg, beg);
+		span_end = kstd::max(span_end, end);
+	}
+	if (span_beg >= span_end)
+		return;
+
+	// carve the bitmap out of the first usable range large enough for it
+	const size_t bitmap_size = BuddyAllocator::get_bitmap_size(span_beg, span_end);
+	const PhysSize bitmap_mem_size = kstd::align_ceiled((PhysSize)bitmap_size, page_size_shift);
+	PhysAddr bitmap_beg = 0;
+	for (size_t i = 0; i < mmap.nr_entries; ++i) {
+		PhysAddr beg, end;
+		if (get_usable_range(mmap.entries[i], beg, end)
+		 && end - beg >= bitmap_mem_size) {
+			bitmap_beg = beg;
+			break;
+		}
+	}
+	if (!bitmap_beg)
+		return;
+	const PhysAddr bitmap_end = bitmap_beg + bitmap_mem_size;
+
+	void *bitmap = arch::phys_to_virt(bitmap_beg);
+	memset(bitmap, 0, bitmap_size);
+	buddy.init(span_beg, span_end, bitmap);
+
+	for (size_t i = 0; i < mmap.nr_entries; ++i) {
+		PhysAddr beg, end;
+		if (!get_usable_range(mmap.entries[i], beg, end))
+			continue;
+		// leave out the bitmap
+		if (beg < bitmap_end && bitmap_beg < end) {
+			if (beg < bitmap_beg)
+				buddy.add_free_memory(beg, bitmap_beg);
+			beg = bitmap_end;
+		}
+		if (beg < end)
+			buddy.add_free_memory(beg, end);
+	}
+}
+
+PhysAddr alloc_frames(unsigned int order, FrameFlags flags)
+{
+	if (order == 0) {
+		IrqGuard irq_guard;
+		FrameCache& cache = frame_caches.get();
+		if (cache.empty())
+			cache.refill();
+		if (cache.empty())
+			return 0;
+		return kstd::test_flag(flags, FrameFlags::Cold) ? cache.pop_cold() : cache.pop_hot();
+	}
+
+	IrqGuard irq_guard;
+	LockGuard guard(buddy_lock);
+	return buddy.alloc(order);
+}
+
+void free_frames(PhysAddr addr, unsigned int order, FrameFlags flags)
+{
+	if (order == 0) {
+		IrqGuard irq_guard;
+		FrameCache& cache = frame_caches.get();
+		if (cache.full())
+			cache.drain(FrameCache::batch_size);
+		if (kstd::test_flag(flags, FrameFlags::Cold))
+			cache.push_cold(addr);
+		else
+			cache.push_hot(addr);
+		return;
+	}
+
+	IrqGuard irq_guard;
+	LockGuard guard(buddy_lock);
+	buddy.free(addr, order);
+}
+
+void drain_frame_cache()
+{
+	IrqGuard irq_guard;
+	FrameCache& cache = frame_caches.get();
+	cache.drain(cache.size());
+}
+
+size_t get_nr_free_frames()
+{
+	size_t nr_free_frames = 0;
+	for (unsigned int cpu = 0; cpu < max_nr_cpus; ++cpu)
+		nr_free_frames += frame_caches.get(cpu).size();
+
+	IrqGuard irq_guard;
+	LockGuard guard(buddy_lock);
+	return nr_free_frames + buddy.get_nr_free_frames();
+}
+
+}
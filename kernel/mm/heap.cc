@@ -0,0 +1,191 @@
+#include <kernel/mm/heap.h>
+#include <kernel/mm/slab.h>
+#include <kernel/mm/frame.h>
+
+#include <kstd/new.h>
+#include <kstd/memory.h>
+#include <kstd/algorithm.h>
+
+
+namespace kernel::mm {
+
+/* Power of 2 sizes and the common sizes halfway between them. */
+static constexpr size_t size_class_sizes[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+	768, 1024, 1536, 2048, 3072, 4096,
+};
+static constexpr unsigned int nr_size_caches = sizeof(size_class_sizes) / sizeof(size_class_sizes[0]);
+
+static SlabCache size_caches[nr_size_caches];
+
+static constexpr size_t max_small_size = size_class_sizes[nr_size_caches - 1];
+static constexpr size_t min_small_align = 16;
+
+/* Size class lookup table with 16 byte granularity for sizes up to 512
+ * and 128 byte granularity above. */
+static constexpr size_t small_size_class_granularity = 16;
+static constexpr size_t small_size_class_limit = 512;
+static constexpr size_t large_size_class_granularity = 128;
+
+struct SizeClassTable {
+	uint8_t small[small_size_class_limit / small_size_class_granularity + 1];
+	uint8_t large[max_small_size / large_size_class_granularity + 1];
+};
+
+static constexpr SizeClassTable size_class_table = []() constexpr
+{
+	auto find_class = [](size_t size) constexpr -> uint8_t
+	{
+		uint8_t i = 0;
+		while (size_class_sizes[i] < size)
+			++i;
+		return i;
+	};
+
+	SizeClassTable table {};
+	for (size_t i = 0; i < sizeof(table.small); ++i)
+		table.small[i] = find_class(i * small_size_class_granularity);
+	for (size_t i = 0; i < sizeof(table.large); ++i)
+		table.large[i] = find_class(i * large_size_class_granularity);
+	return table;
+}();
+
+static unsigned int get_size_class(size_t size)
+{
+	if (size <= small_size_class_limit)
+		return size_class_table.small[
+			(size + small_size_class_granularity - 1) / small_size_class_granularity];
+	return size_class_table.large[
+		(size + large_size_class_granularity - 1) / large_size_class_granularity];
+}
+
+/* Offset of the data of large allocations from their header. */
+static constexpr size_t large_data_offset = arch::cache_line_size;
+static_assert(sizeof(SlabHeader) <= large_data_offset);
+
+static void *alloc_large(size_t size, size_t align)
+{
+	if (align >= slab_size)
+		return nullptr;
+
+	const size_t offset = kstd::max(large_data_offset, align);
+	const size_t total_size = offset + size;
+	if (total_size < size) [[unlikely]]
+		return nullptr;
+
+	// frame blocks of at least a slab size keep the header
+	// reachable the same way as the slab headers are
+	unsigned int order = slab_order;
+	while ((size_t(1) << (order + arch::page_size_shift)) < total_size) {
+		if (++order >= sizeof(size_t) * 8 - arch::page_size_shift)
+			return nullptr;
+	}
+
+	const PhysAddr addr = alloc_frames(order);
+	if (!addr)
+		return nullptr;
+
+	auto *header = new (arch::phys_to_virt(addr)) SlabHeader();
+	header->cache = nullptr;
+	header->order = order;
+	return reinterpret_cast<kstd::Byte *>(header) + offset;
+}
+
+void setup_heap()
+{
+	for (unsigned int i = 0; i < nr_size_caches; ++i)
+		size_caches[i].init(size_class_sizes[i]);
+}
+
+void *kmalloc(size_t size, size_t align)
+{
+	if (size <= max_small_size) [[likely]] {
+		unsigned int size_class = get_size_class(size);
+		if (align > min_small_align) [[unlikely]] {
+			while (size_class < nr_size_caches
+			    && size_caches[size_class].get_object_align() < align)
+				++size_class;
+		}
+		if (size_class < nr_size_caches) [[likely]]
+			return size_caches[size_class].alloc();
+	}
+	return alloc_large(size, align);
+}
+
+void kfree(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	SlabHeader *header = get_slab_header(ptr);
+	if (header->cache)
+		header->cache->free(ptr);
+	else
+		free_frames(arch::virt_to_phys(header), header->order);
+}
+
+}
+
+
+using kernel::mm::kmalloc;
+using kernel::mm::kfree;
+
+void *operator new(size_t size) noexcept
+{
+	return kmalloc(size);
+}
+
+void *operator new[](size_t size) noexcept
+{
+	return kmalloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t align) noexcept
+{
+	return kmalloc(size, static_cast<size_t>(align));
+}
+
+void *operator new[](size_t size, std::align_val_t align) noexcept
+{
+	return kmalloc(size, static_cast<size_t>(align));
+}
+
+void operator delete(void *ptr) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t align) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t align) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete(void *ptr, size_t size, std::align_val_t align) noexcept
+{
+	kfree(ptr);
+}
+
+void operator delete[](void *ptr, size_t size, std::align_val_t align) noexcept
+{
+	kfree(ptr);
+}
@@ -0,0 +1,160 @@
+#include <kernel/mm/slab.h>
+#include <kernel/mm/frame.h>
+#include <kernel/irq.h>
+
+#include <kstd/new.h>
+#include <kstd/memory.h>
+
+#include <string.h>
+
+
+namespace kernel::mm {
+
+/* Number of completely free slabs a cache keeps before giving them back. */
+static constexpr unsigned int max_nr_free_slabs = 1;
+
+void SlabCache::init(size_t object_size)
+{
+	this->object_size = object_size;
+	object_align = get_object_align(object_size);
+	objects_offset = get_objects_offset(object_size);
+	nr_objects_per_slab = (slab_size - objects_offset) / object_size;
+}
+
+void *SlabCache::alloc()
+{
+	IrqGuard irq_guard;
+	Magazine& magazine = magazines.get();
+	if (magazine.nr_objects == 0) [[unlikely]] {
+		refill(magazine, Magazine::capacity / 2);
+		if (magazine.nr_objects == 0)
+			return nullptr;
+	}
+	return magazine.objects[--magazine.nr_objects];
+}
+
+void SlabCache::free(void *ptr)
+{
+	IrqGuard irq_guard;
+	Magazine& magazine = magazines.get();
+	if (magazine.nr_objects == Magazine::capacity) [[unlikely]]
+		drain(magazine, Magazine::capacity / 2);
+	magazine.objects[magazine.nr_objects++] = ptr;
+}
+
+void SlabCache::refill(Magazine& magazine, unsigned int nr)
+{
+	LockGuard guard(lock);
+	for (unsigned int i = 0; i < nr; ++i) {
+		void *ptr = alloc_from_slabs();
+		if (!ptr)
+			break;
+		magazine.objects[magazine.nr_objects++] = ptr;
+	}
+}
+
+void SlabCache::drain(Magazine& magazine, unsigned int nr)
+{
+	{
+		LockGuard guard(lock);
+		// the bottom of the magazine holds the least recently freed objects
+		for (unsigned int i = 0; i < nr; ++i)
+			free_to_slab(magazine.objects[i]);
+	}
+	magazine.nr_objects -= nr;
+	memmove(magazine.objects, magazine.objects + nr,
+			magazine.nr_objects * sizeof(magazine.objects[0]));
+}
+
+void *SlabCache::alloc_from_slabs()
+{
+	Slab *slab = partial_slabs;
+	if (!slab) {
+		if (free_slabs) {
+			slab = free_slabs;
+			unlink_slab(free_slabs, slab);
+			--nr_free_slabs;
+		} else {
+			slab = create_slab();
+			if (!slab)
+				return nullptr;
+		}
+		link_slab(partial_slabs, slab);
+	}
+
+	FreeObject *object = slab->free_objects;
+	slab->free_objects = object->next;
+	++slab->nr_used;
+	// full slabs are not tracked, they get back once an object is freed
+	if (!slab->free_objects)
+		unlink_slab(partial_slabs, slab);
+	return object;
+}
+
+void SlabCache::free_to_slab(void *ptr)
+{
+	Slab *slab = static_cast<Slab *>(get_slab_header(ptr));
+	const bool was_full = !slab->free_objects;
+
+	auto *object = static_cast<FreeObject *>(ptr);
+	object->next = slab->free_objects;
+	slab->free_objects = object;
+	--slab->nr_used;
+
+	if (slab->nr_used == 0) {
+		if (!was_full)
+			unlink_slab(partial_slabs, slab);
+		if (nr_free_slabs < max_nr_free_slabs) {
+			link_slab(free_slabs, slab);
+			++nr_free_slabs;
+		} else {
+			free_frames(arch::virt_to_phys(slab), slab_order);
+		}
+	} else if (was_full) {
+		link_slab(partial_slabs, slab);
+	}
+}
+
+SlabCache::Slab *SlabCache::create_slab()
+{
+	const PhysAddr addr = alloc_frames(slab_order);
+	if (!addr)
+		return nullptr;
+
+	Slab *slab = new (arch::phys_to_virt(addr)) Slab();
+	slab->cache = this;
+	slab->order = slab_order;
+
+	// link the objects in the order of their addresses
+	auto *objects = reinterpret_cast<kstd::Byte *>(slab) + objects_offset;
+	FreeObject *free_objects = nullptr;
+	for (unsigned int i = nr_objects_per_slab; i-- > 0;) {
+		auto *object = reinterpret_cast<FreeObject *>(objects + i * object_size);
+		object->next = free_objects;
+		free_objects = object;
+	}
+	slab->free_objects = free_objects;
+	slab->nr_used = 0;
+	return slab;
+}
+
+void SlabCache::link_slab(Slab *&list, Slab *slab)
+{
+	slab->prev = nullptr;
+	slab->next = list;
+	if (list)
+		list->prev = slab;
+	list = slab;
+}
+
+void SlabCache::unlink_slab(Slab *&list, Slab *slab)
+{
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		list = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+}
+
+}
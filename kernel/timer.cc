@@ -0,0 +1,264 @@
+#include <kernel/timer.h>
+#include <kernel/hrtimer.h>
+#include <kernel/irq.h>
+#include <kernel/percpu.h>
+
+#include <kstd/algorithm.h>
+
+
+namespace kernel {
+
+namespace {
+
+constexpr unsigned int nr_levels = 5;
+constexpr unsigned int first_level_bits = 8;
+constexpr unsigned int level_bits = 6;
+constexpr unsigned int nr_slots = (1 << first_level_bits) + (nr_levels - 1) * (1 << level_bits);
+
+/* Ticks ahead the last level reaches, about 49 days. Timers further away are
+ * put at its end and put back there when cascaded until they're close. */
+constexpr uint64_t max_ticks_ahead =
+	(uint64_t(1) << (first_level_bits + (nr_levels - 1) * level_bits)) - 1;
+
+constexpr uint64_t no_tick = UINT64_MAX;
+
+using BitmapWord = uint64_t;
+constexpr unsigned int bitmap_word_bits = sizeof(BitmapWord) * 8;
+
+/* Each slot of a level spans 2^shift ticks. */
+constexpr unsigned int get_level_shift(unsigned int level)
+{
+	return level ? first_level_bits + (level - 1) * level_bits : 0;
+}
+
+constexpr unsigned int get_level_size(unsigned int level)
+{
+	return level ? 1 << level_bits : 1 << first_level_bits;
+}
+
+constexpr unsigned int get_level_first_slot(unsigned int level)
+{
+	return level ? (1 << first_level_bits) + (level - 1) * (1 << level_bits) : 0;
+}
+
+/* A slot holds the timers of the ticks its level spans, in a list linked
+ * through pprev so any timer can be unlinked without knowing the list.
+ * Timers of a slot are run or cascaded the first time a tick of it is run,
+ * the later rounds of the wheel are never put into the slot before it's due. */
+struct TimerWheel {
+	uint64_t curr_tick = 0; /* Next tick to be run. */
+	Timer *slots[nr_slots] {};
+	/* Bit k is set if slot k is not empty. */
+	BitmapWord nonempty_slots[nr_slots / bitmap_word_bits] {};
+	HrTimer tick_timer; /* Programmed for the next tick with something to do. */
+};
+
+PerCPU<TimerWheel> timer_wheels;
+
+void switch_nonempty(TimerWheel& wheel, unsigned int slot, bool nonempty)
+{
+	const BitmapWord bit = BitmapWord(1) << (slot % bitmap_word_bits);
+	if (nonempty)
+		wheel.nonempty_slots[slot / bitmap_word_bits] |= bit;
+	else
+		wheel.nonempty_slots[slot / bitmap_word_bits] &= ~bit;
+}
+
+void link_timer(TimerWheel& wheel, Timer& timer, unsigned int slot)
+{
+	timer.slot = slot;
+	timer.next = wheel.slots[slot];
+	if (timer.next)
+		timer.next->pprev = &timer.next;
+	timer.pprev = &wheel.slots[slot];
+	wheel.slots[slot] = &timer;
+	switch_nonempty(wheel, slot, true);
+}
+
+void unlink_timer(TimerWheel& wheel, Timer& timer)
+{
+	*timer.pprev = timer.next;
+	if (timer.next)
+		timer.next->pprev = timer.pprev;
+	timer.pprev = nullptr;
+	if (!wheel.slots[timer.slot])
+		switch_nonempty(wheel, timer.slot, false);
+}
+
+/* Take all the timers out of the slot, as a list whose first pprev points to
+ * the slot still. */
+Timer *take_slot(TimerWheel& wheel, unsigned int slot)
+{
+	Timer *timers = wheel.slots[slot];
+	wheel.slots[slot] = nullptr;
+	switch_nonempty(wheel, slot, false);
+	return timers;
+}
+
+/* Put the timer into the slot it belongs to relative to the current tick.
+ * Returns the tick the slot is due at. */
+uint64_t enqueue_timer(TimerWheel& wheel, Timer& timer)
+{
+	// timers already expired go to the next tick
+	const uint64_t ticks_ahead = timer.expires_tick > wheel.curr_tick
+		? kstd::min(timer.expires_tick - wheel.curr_tick, max_ticks_ahead) : 0;
+	const uint64_t tick = wheel.curr_tick + ticks_ahead;
+
+	// the finest level the tick is within the reach of
+	unsigned int level = 0;
+	while (level + 1 < nr_levels && ticks_ahead >> get_level_shift(level + 1))
+		++level;
+
+	const unsigned int shift = get_level_shift(level);
+	const unsigned int idx = (tick >> shift) & (get_level_size(level) - 1);
+	link_timer(wheel, timer, get_level_first_slot(level) + idx);
+	return tick >> shift << shift;
+}
+
+/* Distance of the first nonempty slot of the level from slot idx onwards,
+ * wrapping around, or the size of the level if they're all empty. */
+unsigned int find_nonempty_slot(const TimerWheel& wheel, unsigned int level, unsigned int idx)
+{
+	const unsigned int size = get_level_size(level);
+	const unsigned int nr_words = size / bitmap_word_bits;
+	const BitmapWord *words = wheel.nonempty_slots + get_level_first_slot(level) / bitmap_word_bits;
+	const BitmapWord from_idx = ~BitmapWord(0) << (idx % bitmap_word_bits);
+
+	// the word of idx is looked at twice, for the slots from idx and
+	// for the ones before it after wrapping around
+	for (unsigned int i = 0; i <= nr_words; ++i) {
+		const unsigned int word_idx = (idx / bitmap_word_bits + i) % nr_words;
+		BitmapWord word = words[word_idx];
+		if (i == 0)
+			word &= from_idx;
+		else if (i == nr_words)
+			word &= ~from_idx;
+		if (word) {
+			const unsigned int slot = word_idx * bitmap_word_bits + __builtin_ctzll(word);
+			return (slot - idx) & (size - 1);
+		}
+	}
+	return size;
+}
+
+/* The first tick from the current one on with a slot to run or cascade,
+ * no_tick if the wheel is empty. */
+uint64_t find_next_tick(const TimerWheel& wheel)
+{
+	uint64_t next_tick = no_tick;
+	for (unsigned int level = 0; level < nr_levels; ++level) {
+		// slots of coarser levels are due at the first of their ticks
+		const unsigned int shift = get_level_shift(level);
+		const uint64_t first = (wheel.curr_tick + (uint64_t(1) << shift) - 1) >> shift;
+		const unsigned int size = get_level_size(level);
+		const unsigned int distance = find_nonempty_slot(wheel, level, first & (size - 1));
+		if (distance != size)
+			next_tick = kstd::min(next_tick, (first + distance) << shift);
+	}
+	return next_tick;
+}
+
+void run_tick(TimerWheel& wheel, uint64_t tick)
+{
+	wheel.curr_tick = tick;
+
+	// the slots of coarser levels starting at the tick are moved into the
+	// finer ones, down to the first level
+	for (unsigned int level = 1; level < nr_levels; ++level) {
+		const unsigned int shift = get_level_shift(level);
+		if (tick & ((uint64_t(1) << shift) - 1))
+			break;
+		const unsigned int idx = (tick >> shift) & (get_level_size(level) - 1);
+		Timer *timer = take_slot(wheel, get_level_first_slot(level) + idx);
+		while (timer) {
+			Timer *next = timer->next;
+			enqueue_timer(wheel, *timer);
+			timer = next;
+		}
+	}
+
+	// timers added by the callbacks go to the next tick at the earliest,
+	// and the ones run can be cancelled by them
+	Timer *expired = take_slot(wheel, tick & (get_level_size(0) - 1));
+	if (expired)
+		expired->pprev = &expired;
+	wheel.curr_tick = tick + 1;
+	while (expired) {
+		Timer& timer = *expired;
+		unlink_timer(wheel, timer);
+		timer.callback(timer);
+	}
+}
+
+void arm_tick_timer(TimerWheel& wheel, uint64_t tick)
+{
+	if (tick == no_tick) {
+		cancel_hrtimer(wheel.tick_timer);
+		return;
+	}
+
+	const uint64_t expires = tick * timer_tick_ns;
+	if (!wheel.tick_timer.queued || expires < wheel.tick_timer.expires)
+		add_hrtimer(wheel.tick_timer, expires);
+}
+
+uint64_t get_curr_tick()
+{
+	return ktime_get_ns() / timer_tick_ns;
+}
+
+void run_timer_wheel(HrTimer&)
+{
+	TimerWheel& wheel = timer_wheels.get();
+	const uint64_t now_tick = get_curr_tick();
+
+	// only the ticks with something to do are run, the wheel jumps over
+	// the others
+	uint64_t next_tick;
+	while ((next_tick = find_next_tick(wheel)) <= now_tick)
+		run_tick(wheel, next_tick);
+	wheel.curr_tick = kstd::max(wheel.curr_tick, now_tick + 1);
+
+	arm_tick_timer(wheel, next_tick);
+}
+
+}
+
+void setup_timers()
+{
+	IrqGuard irq_guard;
+	TimerWheel& wheel = timer_wheels.get();
+	wheel.tick_timer.callback = run_timer_wheel;
+	wheel.curr_tick = get_curr_tick();
+}
+
+void add_timer(Timer& timer, uint64_t expires)
+{
+	IrqGuard irq_guard;
+	TimerWheel& wheel = timer_wheels.get();
+	if (timer.pprev)
+		unlink_timer(wheel, timer);
+
+	// an idle wheel is behind, catching it up keeps the timer from going
+	// to a coarser level than needed
+	const uint64_t now_tick = get_curr_tick();
+	if (wheel.curr_tick <= now_tick && find_next_tick(wheel) > now_tick)
+		wheel.curr_tick = now_tick + 1;
+
+	timer.expires = expires;
+	timer.expires_tick = expires / timer_tick_ns + (expires % timer_tick_ns != 0);
+	arm_tick_timer(wheel, enqueue_timer(wheel, timer));
+}
+
+bool cancel_timer(Timer& timer)
+{
+	// the tick timer stays programmed, running the wheel finds nothing
+	// to do then
+	IrqGuard irq_guard;
+	if (!timer.pprev)
+		return false;
+	unlink_timer(timer_wheels.get(), timer);
+	return true;
+}
+
+}
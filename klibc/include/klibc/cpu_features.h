@@ -0,0 +1,21 @@
+#ifndef __KLIBC__CPU_FEATURES_H__
+#define __KLIBC__CPU_FEATURES_H__
+
+namespace klibc {
+
+/* CPU features the klibc routines can take advantage of. */
+enum CpuFeature : unsigned int {
+	CPU_ERMS = 0x1, /* Enhanced rep movsb and rep stosb. */
+	CPU_FSRM = 0x2, /* Fast short rep movsb. */
+	CPU_SSE2 = 0x4,
+	CPU_AVX2 = 0x8, /* Only with the AVX state enabled. */
+};
+
+/* Switch the klibc routines to the implementations best for the given
+ * CPU features. It has to be called once at boot, before the routines are
+ * used concurrently. */
+void set_cpu_features(unsigned int features);
+
+}
+
+#endif
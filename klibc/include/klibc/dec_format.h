@@ -0,0 +1,38 @@
+#ifndef __KLIBC__DEC_FORMAT_H__
+#define __KLIBC__DEC_FORMAT_H__
+
+namespace klibc {
+
+/* Two decimal digits of every number from 0 to 99. */
+inline constexpr char dec_digit_pairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/* Write the decimal digits of val so they end right before end and return
+ * where they start. Two digits are produced per division. */
+template<typename CharT, typename UIntegralT>
+inline CharT *format_dec(CharT *end, UIntegralT val)
+{
+	while (val >= 100) {
+		const unsigned int pair = static_cast<unsigned int>(val % 100) * 2;
+		val /= 100;
+		*--end = dec_digit_pairs[pair + 1];
+		*--end = dec_digit_pairs[pair];
+	}
+
+	if (val >= 10) {
+		const unsigned int pair = static_cast<unsigned int>(val) * 2;
+		*--end = dec_digit_pairs[pair + 1];
+		*--end = dec_digit_pairs[pair];
+	} else {
+		*--end = static_cast<CharT>('0' + val);
+	}
+	return end;
+}
+
+}
+
+#endif
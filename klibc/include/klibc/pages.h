@@ -0,0 +1,19 @@
+#ifndef __KLIBC__PAGES_H__
+#define __KLIBC__PAGES_H__
+
+#include <stddef.h>
+
+namespace klibc {
+
+/* Zero nr_pages pages at the page aligned address dst. The stores go
+ * around the caches when the region is bigger than they are, or when cold
+ * tells the pages won't be read any time soon. */
+void zero_pages(void *dst, size_t nr_pages, bool cold = false);
+
+/* Copy nr_pages pages between page aligned addresses, with the same cache
+ * policy as zero_pages(). */
+void copy_pages(void *dst, const void *src, size_t nr_pages, bool cold = false);
+
+}
+
+#endif
@@ -6,9 +6,15 @@ extern "C" {
 #endif
 
 int atoi(const char *str);
-long atol(const char *srt);
+long atol(const char *str);
 long long atoll(const char *str);
 
+/* Out of range values saturate, there's no errno to report them. */
+long strtol(const char *str, char **end, int base);
+long long strtoll(const char *str, char **end, int base);
+unsigned long strtoul(const char *str, char **end, int base);
+unsigned long long strtoull(const char *str, char **end, int base);
+
 #ifdef __cplusplus
 }
 #endif
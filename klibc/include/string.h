@@ -10,11 +10,14 @@ extern "C" {
 void *memcpy(void *dst, const void *src, size_t cnt);
 void *memmove(void *dst, const void *src, size_t cnt);
 void *memset(void *dst, const int val, size_t cnt);
+int memcmp(const void *s1, const void *s2, size_t cnt);
+void *memchr(const void *ptr, int val, size_t cnt);
 
 size_t strlen(const char *str);
 size_t strnlen(const char *str, size_t n);
 char *strcpy(char *dst, const char *src);
 char *strncpy(char *dst, const char *src, size_t n);
+char *strchr(const char *str, int val);
 
 int strcmp(const char *s1, const char *s2);
 int strncmp(const char *s1, const char *s2, size_t n);
@@ -26,11 +29,14 @@ int strncmp(const char *s1, const char *s2, size_t n);
 #define memcpy(__dst, __src, __cnt) __builtin_memcpy(__dst, __src, __cnt)
 #define memset(__dst, __val, __cnt) __builtin_memset(__dst, __val, __cnt)
 #define memmove(__dst, __src, __cnt) __builtin_memmove(__dst, __src, __cnt)
+#define memcmp(__s1, __s2, __cnt) __builtin_memcmp(__s1, __s2, __cnt)
+#define memchr(__ptr, __val, __cnt) __builtin_memchr(__ptr, __val, __cnt)
 
 #define strlen(__str) __builtin_strlen(__str)
-#define strnlen(__str) __builtin_strnlen(__str)
+#define strnlen(__str, __n) __builtin_strnlen(__str, __n)
 #define strcpy(__dst, __src) __builtin_strcpy(__dst, __src)
 #define strncpy(__dst, __src, __n) __builtin_strncpy(__dst, __src, __n)
+#define strchr(__str, __val) __builtin_strchr(__str, __val)
 
 #define strcmp(__s1, __s2) __builtin_strcmp(__s1, __s2)
 #define strncmp(__s1, __s2, __n) __builtin_strncmp(__s1, __s2, __n)
@@ -0,0 +1,88 @@
+#include <klibc/pages.h>
+#include <config.h>
+#include <string.h>
+
+
+namespace {
+
+constexpr size_t page_size = CONFIG_PAGE_SIZE;
+/* Size from which the stores bypass the caches. Writing more than a
+ * mid-level cache holds through it only evicts the working set. */
+constexpr size_t non_temporal_min_size = 256 * 1024;
+
+#ifdef __x86_64__
+/* SSE2 is always there in 64bit mode. */
+using Chunk = long long __attribute__((vector_size(16), may_alias));
+
+inline void store_non_temporal(Chunk *dst, Chunk val)
+{
+	__builtin_ia32_movntdq(dst, val);
+}
+#else
+using Chunk = unsigned long __attribute__((may_alias));
+
+inline void store_non_temporal(Chunk *dst, Chunk val)
+{
+	asm volatile ("movnti %1, %0" : "=m"(*dst) : "r"(val));
+}
+#endif
+
+constexpr size_t chunks_per_page = page_size / sizeof(Chunk);
+
+/* Non temporal stores are weakly ordered, they have to be fenced before
+ * the pages are handed to anyone else. */
+inline void store_fence()
+{
+	asm volatile ("sfence" ::: "memory");
+}
+
+inline bool use_non_temporal(size_t nr_pages, bool cold)
+{
+	return cold || nr_pages * page_size >= non_temporal_min_size;
+}
+
+}
+
+namespace klibc {
+
+void zero_pages(void *dst, size_t nr_pages, bool cold)
+{
+	if (!use_non_temporal(nr_pages, cold)) {
+		memset(dst, 0, nr_pages * page_size);
+		return;
+	}
+
+	auto *chunk = static_cast<Chunk *>(dst);
+	const Chunk zero = {};
+	for (size_t i = 0; i < nr_pages * chunks_per_page; i += 4) {
+		store_non_temporal(chunk + i, zero);
+		store_non_temporal(chunk + i + 1, zero);
+		store_non_temporal(chunk + i + 2, zero);
+		store_non_temporal(chunk + i + 3, zero);
+	}
+	store_fence();
+}
+
+void copy_pages(void *dst, const void *src, size_t nr_pages, bool cold)
+{
+	if (!use_non_temporal(nr_pages, cold)) {
+		memcpy(dst, src, nr_pages * page_size);
+		return;
+	}
+
+	auto *dst_chunk = static_cast<Chunk *>(dst);
+	const auto *src_chunk = static_cast<const Chunk *>(src);
+	for (size_t i = 0; i < nr_pages * chunks_per_page; i += 4) {
+		const Chunk c0 = src_chunk[i];
+		const Chunk c1 = src_chunk[i + 1];
+		const Chunk c2 = src_chunk[i + 2];
+		const Chunk c3 = src_chunk[i + 3];
+		store_non_temporal(dst_chunk + i, c0);
+		store_non_temporal(dst_chunk + i + 1, c1);
+		store_non_temporal(dst_chunk + i + 2, c2);
+		store_non_temporal(dst_chunk + i + 3, c3);
+	}
+	store_fence();
+}
+
+}
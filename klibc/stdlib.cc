@@ -2,44 +2,108 @@
 #include <ctype.h>
 
 
-template<typename T>
-static int ato_T(const char *str)
+/* Value of the digit c in bases up to 36, 36 if it isn't a digit. */
+static int digit_value(char c)
 {
-	while (isspace(*str))
-		++str;
+	if (isdigit(c))
+		return c - '0';
+	const char lower = c | 0x20;
+	if ('a' <= lower && lower <= 'z')
+		return lower - 'a' + 10;
+	return 36;
+}
 
-	bool negative = false;
+/* Parse an integer the way the strto* functions do. Values out of the
+ * range of T saturate to its limits, there's no errno in the kernel so
+ * the limits and end are all the caller gets. */
+template<typename T, typename UT>
+static T strto_T(const char *str, char **end, int base)
+{
+	constexpr bool is_signed = T(-1) < T(0);
+	const char *c = str;
 
-	if (*str == '+')
-		++str;
-	else if (*str == '-')
-	{
-		++str;
+	while (isspace(*c))
+		++c;
+
+	bool negative = false;
+	if (*c == '+') {
+		++c;
+	} else if (*c == '-') {
+		++c;
 		negative = true;
 	}
 
-	T result = 0;
-	for (; isdigit(*str); ++str)
-	{
-		int digit = *str - '0';
-		result *= 10;
-		result -= digit;
+	if ((base == 0 || base == 16) && c[0] == '0' && (c[1] | 0x20) == 'x'
+			&& digit_value(c[2]) < 16) {
+		c += 2;
+		base = 16;
+	} else if (base == 0) {
+		base = *c == '0' ? 8 : 10;
+	}
+
+	if (base < 2 || base > 36) {
+		if (end)
+			*end = const_cast<char *>(str);
+		return 0;
+	}
+
+	// largest magnitude the result can have
+	const UT t_max = is_signed ? UT(-1) >> 1 : UT(-1);
+	const UT limit = is_signed && negative ? t_max + 1 : t_max;
+
+	const char *const digits = c;
+	UT value = 0;
+	bool overflow = false;
+	for (int digit; (digit = digit_value(*c)) < base; ++c) {
+		overflow |= __builtin_mul_overflow(value, UT(base), &value)
+			|| __builtin_add_overflow(value, UT(digit), &value)
+			|| value > limit;
+	}
+
+	if (c == digits) {
+		if (end)
+			*end = const_cast<char *>(str);
+		return 0;
 	}
+	if (end)
+		*end = const_cast<char *>(c);
 
-	return negative ? result : -result;
+	if (overflow)
+		return is_signed && negative ? T(t_max + 1) : T(t_max);
+	return negative ? T(UT(0) - value) : T(value);
+}
+
+extern "C" long strtol(const char *str, char **end, int base)
+{
+	return strto_T<long, unsigned long>(str, end, base);
+}
+
+extern "C" long long strtoll(const char *str, char **end, int base)
+{
+	return strto_T<long long, unsigned long long>(str, end, base);
+}
+
+extern "C" unsigned long strtoul(const char *str, char **end, int base)
+{
+	return strto_T<unsigned long, unsigned long>(str, end, base);
+}
+
+extern "C" unsigned long long strtoull(const char *str, char **end, int base)
+{
+	return strto_T<unsigned long long, unsigned long long>(str, end, base);
 }
 
 extern "C" int atoi(const char *str)
 {
-	return ato_T<int>(str);
+	return strto_T<long, unsigned long>(str, nullptr, 10);
 }
 
 extern "C" long atol(const char *str)
 {
-	return ato_T<long>(str);
+	return strto_T<long, unsigned long>(str, nullptr, 10);
 }
 
 extern "C" long long atoll(const char *str)
 {
-	return ato_T<long long>(str);
+	return strto_T<long long, unsigned long long>(str, nullptr, 10);
 }
@@ -1,59 +1,496 @@
 #include <stddef.h>
+#include <stdint.h>
 
-extern "C" {
+#include <klibc/cpu_features.h>
 
-void *memcpy(void *dst, const void *src, size_t cnt)
+#include "string_ops.h"
+
+
+namespace {
+
+using Word = unsigned long;
+/* Word that can be accessed at any address. */
+using UnalignedWord = Word __attribute__((aligned(1), may_alias));
+using AlignedWord = Word __attribute__((may_alias));
+
+constexpr size_t word_size = sizeof(Word);
+/* Size the memory routines have a fast path for. */
+constexpr size_t page_size = 4096;
+/* Size from which rep movsb and rep stosb outrun the loops on CPUs with ERMS. */
+constexpr size_t erms_min_size = 256;
+
+/* The .bss of the 32bit entry code is discarded. */
+__attribute__((section(".data"))) unsigned int cpu_features = 0;
+
+inline bool is_word_aligned(const void *ptr)
+{
+	return !(reinterpret_cast<uintptr_t>(ptr) & (word_size - 1));
+}
+
+inline void rep_movsb(void *dst, const void *src, size_t cnt)
 {
-	const char *c_src = (const char *)src;
-	char *c_dst = (char *)dst;
+	asm volatile ("rep movsb"
+		: "+D"(dst), "+S"(src), "+c"(cnt) :: "memory");
+}
+
+inline void rep_stosb(void *dst, unsigned char val, size_t cnt)
+{
+	asm volatile ("rep stosb"
+		: "+D"(dst), "+c"(cnt) : "a"(val) : "memory");
+}
+
+/* Copy nr_words words between word aligned addresses. */
+inline void rep_movs_words(void *dst, const void *src, size_t nr_words)
+{
+#ifdef __x86_64__
+	asm volatile ("rep movsq"
+#else
+	asm volatile ("rep movsl"
+#endif
+		: "+D"(dst), "+S"(src), "+c"(nr_words) :: "memory");
+}
+
+/* Fill nr_words words at a word aligned address. */
+inline void rep_stos_words(void *dst, Word val, size_t nr_words)
+{
+#ifdef __x86_64__
+	asm volatile ("rep stosq"
+#else
+	asm volatile ("rep stosl"
+#endif
+		: "+D"(dst), "+c"(nr_words) : "a"(val) : "memory");
+}
+
+/* Copy from the lowest address up. The destination is aligned to a word,
+ * the source is read a word at a time wherever it lies. It's fine for the
+ * destination to overlap the source from below. */
+__NO_LIBCALLS void copy_forward(unsigned char *dst, const unsigned char *src, size_t cnt)
+{
+	if (cnt >= word_size) {
+		for (; !is_word_aligned(dst); --cnt)
+			*dst++ = *src++;
+
+		for (; cnt >= 4 * word_size; cnt -= 4 * word_size) {
+			const Word w0 = reinterpret_cast<const UnalignedWord *>(src)[0];
+			const Word w1 = reinterpret_cast<const UnalignedWord *>(src)[1];
+			const Word w2 = reinterpret_cast<const UnalignedWord *>(src)[2];
+			const Word w3 = reinterpret_cast<const UnalignedWord *>(src)[3];
+			reinterpret_cast<AlignedWord *>(dst)[0] = w0;
+			reinterpret_cast<AlignedWord *>(dst)[1] = w1;
+			reinterpret_cast<AlignedWord *>(dst)[2] = w2;
+			reinterpret_cast<AlignedWord *>(dst)[3] = w3;
+			dst += 4 * word_size;
+			src += 4 * word_size;
+		}
+		for (; cnt >= word_size; cnt -= word_size) {
+			*reinterpret_cast<AlignedWord *>(dst) =
+				*reinterpret_cast<const UnalignedWord *>(src);
+			dst += word_size;
+			src += word_size;
+		}
+	}
 
 	while (cnt--)
-		*c_dst++ = *c_src++;
+		*dst++ = *src++;
+}
 
-	return dst;
+/* Copy from the highest address down, for the destination overlapping
+ * the source from above. */
+__NO_LIBCALLS void copy_backward(unsigned char *dst, const unsigned char *src, size_t cnt)
+{
+	dst += cnt;
+	src += cnt;
+
+	if (cnt >= word_size) {
+		for (; !is_word_aligned(dst); --cnt)
+			*--dst = *--src;
+
+		for (; cnt >= 4 * word_size; cnt -= 4 * word_size) {
+			dst -= 4 * word_size;
+			src -= 4 * word_size;
+			const Word w3 = reinterpret_cast<const UnalignedWord *>(src)[3];
+			const Word w2 = reinterpret_cast<const UnalignedWord *>(src)[2];
+			const Word w1 = reinterpret_cast<const UnalignedWord *>(src)[1];
+			const Word w0 = reinterpret_cast<const UnalignedWord *>(src)[0];
+			reinterpret_cast<AlignedWord *>(dst)[3] = w3;
+			reinterpret_cast<AlignedWord *>(dst)[2] = w2;
+			reinterpret_cast<AlignedWord *>(dst)[1] = w1;
+			reinterpret_cast<AlignedWord *>(dst)[0] = w0;
+		}
+		for (; cnt >= word_size; cnt -= word_size) {
+			dst -= word_size;
+			src -= word_size;
+			*reinterpret_cast<AlignedWord *>(dst) =
+				*reinterpret_cast<const UnalignedWord *>(src);
+		}
+	}
+
+	while (cnt--)
+		*--dst = *--src;
 }
 
-void *memmove(void *dst, const void *src, size_t cnt)
+__NO_LIBCALLS void fill(unsigned char *dst, unsigned char val, size_t cnt)
 {
-	char *c_dst = (char *)dst;
-	const char *c_src = (const char *)src;
+	if (cnt >= word_size) {
+		for (; !is_word_aligned(dst); --cnt)
+			*dst++ = val;
 
-	if (c_dst <= c_src) {
-		while (cnt--)
-			*c_dst++ = *c_src++;
-	} else {
-		c_dst += cnt;
-		c_src += cnt;
-		while (cnt--)
-			*--c_dst = *--c_src;
+		const Word word_val = Word(-1) / 0xFF * val;
+		for (; cnt >= 4 * word_size; cnt -= 4 * word_size) {
+			reinterpret_cast<AlignedWord *>(dst)[0] = word_val;
+			reinterpret_cast<AlignedWord *>(dst)[1] = word_val;
+			reinterpret_cast<AlignedWord *>(dst)[2] = word_val;
+			reinterpret_cast<AlignedWord *>(dst)[3] = word_val;
+			dst += 4 * word_size;
+		}
+		for (; cnt >= word_size; cnt -= word_size) {
+			*reinterpret_cast<AlignedWord *>(dst) = word_val;
+			dst += word_size;
+		}
 	}
 
+	while (cnt--)
+		*dst++ = val;
+}
+
+inline bool use_rep_movsb(size_t cnt)
+{
+	return (cpu_features & klibc::CPU_FSRM)
+		|| ((cpu_features & klibc::CPU_ERMS) && cnt >= erms_min_size);
+}
+
+void *memcpy_generic(void *dst, const void *src, size_t cnt)
+{
+	// whole pages are moved by the microcoded string copy at full speed
+	if (cnt == page_size && is_word_aligned(dst) && is_word_aligned(src))
+		rep_movs_words(dst, src, page_size / word_size);
+	else
+		copy_forward(static_cast<unsigned char *>(dst),
+				static_cast<const unsigned char *>(src), cnt);
 	return dst;
 }
 
-void *memset(void *dst, const int val, size_t cnt)
+void *memset_generic(void *dst, int val, size_t cnt)
 {
-	char *c_dst = (char *)dst;
-	while (cnt--)
-		*c_dst++ = val;
+	if (cnt == page_size && is_word_aligned(dst))
+		rep_stos_words(dst, Word(-1) / 0xFF * (unsigned char)val, page_size / word_size);
+	else
+		fill(static_cast<unsigned char *>(dst), val, cnt);
 	return dst;
 }
 
+int memcmp_generic(const void *s1, const void *s2, size_t cnt)
+{
+	const auto *c_s1 = static_cast<const unsigned char *>(s1);
+	const auto *c_s2 = static_cast<const unsigned char *>(s2);
 
-size_t strlen(const char *str)
+	// skip the equal words, the bytes tell which one is greater
+	for (; cnt >= word_size; cnt -= word_size) {
+		if (*reinterpret_cast<const UnalignedWord *>(c_s1)
+				!= *reinterpret_cast<const UnalignedWord *>(c_s2))
+			break;
+		c_s1 += word_size;
+		c_s2 += word_size;
+	}
+
+	for (; cnt; --cnt, ++c_s1, ++c_s2) {
+		if (*c_s1 != *c_s2)
+			return *c_s1 - *c_s2;
+	}
+	return 0;
+}
+
+/* Word with every byte set to val. */
+inline Word repeat_byte(unsigned char val)
+{
+	return Word(-1) / 0xFF * val;
+}
+
+/* Not zero if any byte of the word is zero. */
+inline Word has_zero_byte(Word word)
+{
+	return (word - repeat_byte(0x01)) & ~word & repeat_byte(0x80);
+}
+
+/* The string routines only read whole words when they're aligned. Those
+ * never cross into the next page, so reading past the end of a string
+ * can't fault. */
+inline Word load_word(const void *ptr)
+{
+	return *static_cast<const AlignedWord *>(ptr);
+}
+
+inline int char_diff(char c1, char c2)
+{
+	return static_cast<unsigned char>(c1) - static_cast<unsigned char>(c2);
+}
+
+__NO_LIBCALLS size_t strlen_generic(const char *str)
+{
+	const char *c = str;
+	for (; !is_word_aligned(c); ++c) {
+		if (!*c)
+			return c - str;
+	}
+
+	while (!has_zero_byte(load_word(c)))
+		c += word_size;
+
+	while (*c)
+		++c;
+	return c - str;
+}
+
+__NO_LIBCALLS size_t strnlen_generic(const char *str, size_t n)
 {
 	size_t len = 0;
-	while (*str++)
+	for (; len < n && !is_word_aligned(str + len); ++len) {
+		if (!str[len])
+			return len;
+	}
+
+	while (n - len >= word_size && !has_zero_byte(load_word(str + len)))
+		len += word_size;
+
+	while (len < n && str[len])
 		++len;
 	return len;
 }
 
+__NO_LIBCALLS void *memchr_generic(const void *ptr, int val, size_t cnt)
+{
+	const auto *c = static_cast<const unsigned char *>(ptr);
+	const unsigned char byte = val;
+
+	for (; cnt && !is_word_aligned(c); --cnt, ++c) {
+		if (*c == byte)
+			return const_cast<unsigned char *>(c);
+	}
+
+	const Word pattern = repeat_byte(byte);
+	for (; cnt >= word_size && !has_zero_byte(load_word(c) ^ pattern); cnt -= word_size)
+		c += word_size;
+
+	for (; cnt; --cnt, ++c) {
+		if (*c == byte)
+			return const_cast<unsigned char *>(c);
+	}
+	return nullptr;
+}
+
+__NO_LIBCALLS char *strchr_generic(const char *str, int val)
+{
+	const char ch = val;
+
+	for (; !is_word_aligned(str); ++str) {
+		if (*str == ch)
+			return const_cast<char *>(str);
+		if (!*str)
+			return nullptr;
+	}
+
+	const Word pattern = repeat_byte(ch);
+	for (;; str += word_size) {
+		const Word word = load_word(str);
+		if (has_zero_byte(word) || has_zero_byte(word ^ pattern))
+			break;
+	}
+
+	for (; *str != ch; ++str) {
+		if (!*str)
+			return nullptr;
+	}
+	return const_cast<char *>(str);
+}
+
+/* Strings are compared a word at a time only when both can be read
+ * aligned, otherwise one byte at a time. */
+inline bool same_word_offset(const char *s1, const char *s2)
+{
+	return !((reinterpret_cast<uintptr_t>(s1) ^ reinterpret_cast<uintptr_t>(s2))
+			& (word_size - 1));
+}
+
+__NO_LIBCALLS int strcmp_generic(const char *s1, const char *s2)
+{
+	if (same_word_offset(s1, s2)) {
+		for (; !is_word_aligned(s1); ++s1, ++s2) {
+			if (!*s1 || *s1 != *s2)
+				return char_diff(*s1, *s2);
+		}
+
+		for (;; s1 += word_size, s2 += word_size) {
+			const Word word = load_word(s1);
+			if (word != load_word(s2) || has_zero_byte(word))
+				break;
+		}
+	}
+
+	for (; *s1 && *s1 == *s2; ++s1, ++s2);
+	return char_diff(*s1, *s2);
+}
+
+__NO_LIBCALLS int strncmp_generic(const char *s1, const char *s2, size_t n)
+{
+	if (same_word_offset(s1, s2)) {
+		for (; n && !is_word_aligned(s1); --n, ++s1, ++s2) {
+			if (!*s1 || *s1 != *s2)
+				return char_diff(*s1, *s2);
+		}
+
+		for (; n >= word_size; n -= word_size, s1 += word_size, s2 += word_size) {
+			const Word word = load_word(s1);
+			if (word != load_word(s2) || has_zero_byte(word))
+				break;
+		}
+	}
+
+	for (; n; --n, ++s1, ++s2) {
+		if (!*s1 || *s1 != *s2)
+			return char_diff(*s1, *s2);
+	}
+	return 0;
+}
+
+/* Starts with the generic routines, the ones the 32bit entry code runs. */
+klibc::StringOps string_ops = {
+	.memcpy = memcpy_generic,
+	.memset = memset_generic,
+	.memcmp = memcmp_generic,
+	.strlen = strlen_generic,
+	.strnlen = strnlen_generic,
+	.strcmp = strcmp_generic,
+	.strncmp = strncmp_generic,
+	.memchr = memchr_generic,
+	.strchr = strchr_generic,
+	.memcpy_small = memcpy_generic,
+	.memset_small = memset_generic,
+};
+
+void *memcpy_erms(void *dst, const void *src, size_t cnt)
+{
+	if (cnt < erms_min_size)
+		return string_ops.memcpy_small(dst, src, cnt);
+	rep_movsb(dst, src, cnt);
+	return dst;
+}
+
+void *memcpy_fsrm(void *dst, const void *src, size_t cnt)
+{
+	rep_movsb(dst, src, cnt);
+	return dst;
+}
+
+void *memset_erms(void *dst, int val, size_t cnt)
+{
+	if (cnt < erms_min_size)
+		return string_ops.memset_small(dst, val, cnt);
+	rep_stosb(dst, val, cnt);
+	return dst;
+}
+
+}
+
+namespace klibc {
+
+void set_cpu_features(unsigned int features)
+{
+	cpu_features = features;
+
+	// the table is patched entry by entry and every state in between is
+	// valid, the routines may be running meanwhile
+#ifdef __x86_64__
+	if (features & CPU_AVX2) {
+		string_ops.memcpy_small = memcpy_avx2;
+		string_ops.memset_small = memset_avx2;
+		string_ops.memcmp = memcmp_avx2;
+		string_ops.strlen = strlen_avx2;
+		string_ops.strnlen = strnlen_avx2;
+		string_ops.strcmp = strcmp_avx2;
+		string_ops.strncmp = strncmp_avx2;
+		string_ops.memchr = memchr_avx2;
+		string_ops.strchr = strchr_avx2;
+	} else if (features & CPU_SSE2) {
+		string_ops.memcpy_small = memcpy_sse2;
+		string_ops.memset_small = memset_sse2;
+		string_ops.memcmp = memcmp_sse2;
+		string_ops.strlen = strlen_sse2;
+		string_ops.strnlen = strnlen_sse2;
+		string_ops.strcmp = strcmp_sse2;
+		string_ops.strncmp = strncmp_sse2;
+		string_ops.memchr = memchr_sse2;
+		string_ops.strchr = strchr_sse2;
+	}
+#endif
+
+	if (features & CPU_FSRM)
+		string_ops.memcpy = memcpy_fsrm;
+	else if (features & CPU_ERMS)
+		string_ops.memcpy = memcpy_erms;
+	else
+		string_ops.memcpy = string_ops.memcpy_small;
+
+	if (features & CPU_ERMS)
+		string_ops.memset = memset_erms;
+	else
+		string_ops.memset = string_ops.memset_small;
+}
+
+}
+
+extern "C" {
+
+void *memcpy(void *dst, const void *src, size_t cnt)
+{
+	return string_ops.memcpy(dst, src, cnt);
+}
+
+void *memmove(void *dst, const void *src, size_t cnt)
+{
+	auto *c_dst = static_cast<unsigned char *>(dst);
+	const auto *c_src = static_cast<const unsigned char *>(src);
+
+	if (c_dst <= c_src || c_dst >= c_src + cnt) {
+		// copying up is safe, the string copy moves the bytes in order
+		if (use_rep_movsb(cnt))
+			rep_movsb(dst, src, cnt);
+		else
+			copy_forward(c_dst, c_src, cnt);
+	} else {
+		copy_backward(c_dst, c_src, cnt);
+	}
+	return dst;
+}
+
+void *memset(void *dst, const int val, size_t cnt)
+{
+	return string_ops.memset(dst, val, cnt);
+}
+
+int memcmp(const void *s1, const void *s2, size_t cnt)
+{
+	return string_ops.memcmp(s1, s2, cnt);
+}
+
+
+size_t strlen(const char *str)
+{
+	return string_ops.strlen(str);
+}
+
 size_t strnlen(const char *str, size_t n)
 {
-	size_t len = 0;
-	while (len <= n && *str++)
-		++len;
-	return len;
+	return string_ops.strnlen(str, n);
+}
+
+void *memchr(const void *ptr, int val, size_t cnt)
+{
+	return string_ops.memchr(ptr, val, cnt);
+}
+
+char *strchr(const char *str, int val)
+{
+	return string_ops.strchr(str, val);
 }
 
 char *strcpy(char *dst, const char *src)
@@ -74,24 +511,12 @@ char *strncpy(char *dst, const char *src, size_t n)
 
 int strcmp(const char *s1, const char *s2)
 {
-	while (*s1 && (*s1 == *s2)) {
-		s1++;
-		s2++;
-	}
-	return *(const unsigned char *)s1 - *(const unsigned char *)s2;
+	return string_ops.strcmp(s1, s2);
 }
 
 int strncmp(const char *s1, const char *s2, size_t n)
 {
-	while (n && *s1 && (*s1 == *s2)) {
-		n--;
-		s1++;
-		s2++;
-	}
-	if (n == 0)
-		return 0;
-	else
-		return *(const unsigned char *)s1 - *(const unsigned char *)s2;
+	return string_ops.strncmp(s1, s2, n);
 }
 
 }
@@ -0,0 +1,72 @@
+#ifdef __x86_64__
+
+/* Only called once CPUID reported AVX2 and the OS enabled the AVX state. */
+#pragma GCC target("avx2")
+
+#include "string_vector.h"
+
+namespace {
+
+struct Avx2 {
+	static constexpr size_t size = 32;
+	using Bytes = char __attribute__((vector_size(32), may_alias));
+	using UnalignedBytes = char __attribute__((vector_size(32), aligned(1), may_alias));
+
+	static __FORCE_INLINE unsigned int mask(Bytes bytes)
+	{
+		return __builtin_ia32_pmovmskb256(bytes);
+	}
+};
+
+}
+
+namespace klibc {
+
+__NO_LIBCALLS void *memcpy_avx2(void *dst, const void *src, size_t cnt)
+{
+	return vector::memcpy<Avx2>(dst, src, cnt);
+}
+
+__NO_LIBCALLS void *memset_avx2(void *dst, int val, size_t cnt)
+{
+	return vector::memset<Avx2>(dst, val, cnt);
+}
+
+int memcmp_avx2(const void *s1, const void *s2, size_t cnt)
+{
+	return vector::memcmp<Avx2>(s1, s2, cnt);
+}
+
+size_t strlen_avx2(const char *str)
+{
+	return vector::strlen<Avx2>(str);
+}
+
+size_t strnlen_avx2(const char *str, size_t n)
+{
+	return vector::strnlen<Avx2>(str, n);
+}
+
+int strcmp_avx2(const char *s1, const char *s2)
+{
+	return vector::strcmp<Avx2>(s1, s2);
+}
+
+int strncmp_avx2(const char *s1, const char *s2, size_t n)
+{
+	return vector::strncmp<Avx2>(s1, s2, n);
+}
+
+void *memchr_avx2(const void *ptr, int val, size_t cnt)
+{
+	return vector::memchr<Avx2>(ptr, val, cnt);
+}
+
+char *strchr_avx2(const char *str, int val)
+{
+	return vector::strchr<Avx2>(str, val);
+}
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __KLIBC__STRING_OPS_H__
+#define __KLIBC__STRING_OPS_H__
+
+#include <stddef.h>
+
+/* Keep the compiler from turning the loops of the string routines into
+ * calls to the very functions they implement. */
+#define __NO_LIBCALLS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+namespace klibc {
+
+/* Implementations the string routines dispatch to. The generic ones are
+ * used until set_cpu_features() picks the best ones for the CPU. */
+struct StringOps {
+	void *(*memcpy)(void *dst, const void *src, size_t cnt);
+	void *(*memset)(void *dst, int val, size_t cnt);
+	int (*memcmp)(const void *s1, const void *s2, size_t cnt);
+	size_t (*strlen)(const char *str);
+	size_t (*strnlen)(const char *str, size_t n);
+	int (*strcmp)(const char *s1, const char *s2);
+	int (*strncmp)(const char *s1, const char *s2, size_t n);
+	void *(*memchr)(const void *ptr, int val, size_t cnt);
+	char *(*strchr)(const char *str, int val);
+	/* Loops the rep movsb and rep stosb variants fall back to for sizes
+	 * the string instructions are slow at. */
+	void *(*memcpy_small)(void *dst, const void *src, size_t cnt);
+	void *(*memset_small)(void *dst, int val, size_t cnt);
+};
+
+#ifdef __x86_64__
+void *memcpy_sse2(void *dst, const void *src, size_t cnt);
+void *memset_sse2(void *dst, int val, size_t cnt);
+int memcmp_sse2(const void *s1, const void *s2, size_t cnt);
+size_t strlen_sse2(const char *str);
+size_t strnlen_sse2(const char *str, size_t n);
+int strcmp_sse2(const char *s1, const char *s2);
+int strncmp_sse2(const char *s1, const char *s2, size_t n);
+void *memchr_sse2(const void *ptr, int val, size_t cnt);
+char *strchr_sse2(const char *str, int val);
+
+void *memcpy_avx2(void *dst, const void *src, size_t cnt);
+void *memset_avx2(void *dst, int val, size_t cnt);
+int memcmp_avx2(const void *s1, const void *s2, size_t cnt);
+size_t strlen_avx2(const char *str);
+size_t strnlen_avx2(const char *str, size_t n);
+int strcmp_avx2(const char *s1, const char *s2);
+int strncmp_avx2(const char *s1, const char *s2, size_t n);
+void *memchr_avx2(const void *ptr, int val, size_t cnt);
+char *strchr_avx2(const char *str, int val);
+#endif
+
+}
+
+#endif
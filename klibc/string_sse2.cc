@@ -0,0 +1,71 @@
+#ifdef __x86_64__
+
+#include "string_vector.h"
+
+/* Every 64bit capable CPU has SSE2, so these are always available in the
+ * 64bit kernel. */
+namespace {
+
+struct Sse2 {
+	static constexpr size_t size = 16;
+	using Bytes = char __attribute__((vector_size(16), may_alias));
+	using UnalignedBytes = char __attribute__((vector_size(16), aligned(1), may_alias));
+
+	static __FORCE_INLINE unsigned int mask(Bytes bytes)
+	{
+		return __builtin_ia32_pmovmskb128(bytes);
+	}
+};
+
+}
+
+namespace klibc {
+
+__NO_LIBCALLS void *memcpy_sse2(void *dst, const void *src, size_t cnt)
+{
+	return vector::memcpy<Sse2>(dst, src, cnt);
+}
+
+__NO_LIBCALLS void *memset_sse2(void *dst, int val, size_t cnt)
+{
+	return vector::memset<Sse2>(dst, val, cnt);
+}
+
+int memcmp_sse2(const void *s1, const void *s2, size_t cnt)
+{
+	return vector::memcmp<Sse2>(s1, s2, cnt);
+}
+
+size_t strlen_sse2(const char *str)
+{
+	return vector::strlen<Sse2>(str);
+}
+
+size_t strnlen_sse2(const char *str, size_t n)
+{
+	return vector::strnlen<Sse2>(str, n);
+}
+
+int strcmp_sse2(const char *s1, const char *s2)
+{
+	return vector::strcmp<Sse2>(s1, s2);
+}
+
+int strncmp_sse2(const char *s1, const char *s2, size_t n)
+{
+	return vector::strncmp<Sse2>(s1, s2, n);
+}
+
+void *memchr_sse2(const void *ptr, int val, size_t cnt)
+{
+	return vector::memchr<Sse2>(ptr, val, cnt);
+}
+
+char *strchr_sse2(const char *str, int val)
+{
+	return vector::strchr<Sse2>(str, val);
+}
+
+}
+
+#endif
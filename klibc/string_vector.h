@@ -0,0 +1,375 @@
+#ifndef __KLIBC__STRING_VECTOR_H__
+#define __KLIBC__STRING_VECTOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <compiler_attributes.h>
+
+#include "string_ops.h"
+
+/* String routines written once for any vector width. Vec describes the
+ * vector registers:
+ *   size           - width in bytes
+ *   Bytes          - vector of size chars
+ *   UnalignedBytes - Bytes that can be accessed at any address
+ *   mask(v)        - bit i set if the top bit of byte i of v is set
+ * The including file instantiates them with the target the vector
+ * instructions need enabled. */
+namespace klibc::vector {
+
+template<typename Vec>
+__FORCE_INLINE typename Vec::Bytes load(const void *ptr)
+{
+	return *static_cast<const typename Vec::UnalignedBytes *>(ptr);
+}
+
+template<typename Vec>
+__FORCE_INLINE void store(void *ptr, typename Vec::Bytes val)
+{
+	*static_cast<typename Vec::UnalignedBytes *>(ptr) = val;
+}
+
+template<typename Vec>
+__FORCE_INLINE typename Vec::Bytes load_aligned(const void *ptr)
+{
+	return *static_cast<const typename Vec::Bytes *>(ptr);
+}
+
+template<typename Vec>
+__FORCE_INLINE void store_aligned(void *ptr, typename Vec::Bytes val)
+{
+	*static_cast<typename Vec::Bytes *>(ptr) = val;
+}
+
+/* Mask with a bit set for every byte of a and b that are equal. */
+template<typename Vec>
+__FORCE_INLINE unsigned int equal_mask(typename Vec::Bytes a, typename Vec::Bytes b)
+{
+	return Vec::mask((typename Vec::Bytes)(a == b));
+}
+
+template<typename Vec>
+constexpr unsigned int full_mask = Vec::size == 32 ? ~0u : (1u << Vec::size) - 1;
+
+/* Copy less than two vectors, with accesses overlapping in the middle. */
+template<typename Vec>
+__FORCE_INLINE void copy_short(unsigned char *dst, const unsigned char *src, size_t cnt)
+{
+	if (cnt >= Vec::size) {
+		const auto head = load<Vec>(src);
+		const auto tail = load<Vec>(src + cnt - Vec::size);
+		store<Vec>(dst, head);
+		store<Vec>(dst + cnt - Vec::size, tail);
+	} else if (Vec::size > 16 && cnt >= 16) {
+		using U128 = char __attribute__((vector_size(16), aligned(1), may_alias));
+		const U128 head = *reinterpret_cast<const U128 *>(src);
+		const U128 tail = *reinterpret_cast<const U128 *>(src + cnt - 16);
+		*reinterpret_cast<U128 *>(dst) = head;
+		*reinterpret_cast<U128 *>(dst + cnt - 16) = tail;
+	} else if (cnt >= 8) {
+		using U64 = uint64_t __attribute__((aligned(1), may_alias));
+		const uint64_t head = *reinterpret_cast<const U64 *>(src);
+		const uint64_t tail = *reinterpret_cast<const U64 *>(src + cnt - 8);
+		*reinterpret_cast<U64 *>(dst) = head;
+		*reinterpret_cast<U64 *>(dst + cnt - 8) = tail;
+	} else if (cnt >= 4) {
+		using U32 = uint32_t __attribute__((aligned(1), may_alias));
+		const uint32_t head = *reinterpret_cast<const U32 *>(src);
+		const uint32_t tail = *reinterpret_cast<const U32 *>(src + cnt - 4);
+		*reinterpret_cast<U32 *>(dst) = head;
+		*reinterpret_cast<U32 *>(dst + cnt - 4) = tail;
+	} else {
+		while (cnt--)
+			*dst++ = *src++;
+	}
+}
+
+template<typename Vec>
+__FORCE_INLINE void *memcpy(void *dst, const void *src, size_t cnt)
+{
+	auto *c_dst = static_cast<unsigned char *>(dst);
+	const auto *c_src = static_cast<const unsigned char *>(src);
+
+	if (cnt < 2 * Vec::size) {
+		copy_short<Vec>(c_dst, c_src, cnt);
+		return dst;
+	}
+
+	// the unaligned first and last vectors are stored after the loop, it
+	// only has to cover what's between them
+	const auto head = load<Vec>(c_src);
+	const auto tail = load<Vec>(c_src + cnt - Vec::size);
+	unsigned char *const last = c_dst + cnt - Vec::size;
+
+	const size_t skip = Vec::size - (reinterpret_cast<uintptr_t>(c_dst) & (Vec::size - 1));
+	c_dst += skip;
+	c_src += skip;
+	cnt -= skip;
+
+	for (; cnt >= 4 * Vec::size; cnt -= 4 * Vec::size) {
+		const auto v0 = load<Vec>(c_src);
+		const auto v1 = load<Vec>(c_src + Vec::size);
+		const auto v2 = load<Vec>(c_src + 2 * Vec::size);
+		const auto v3 = load<Vec>(c_src + 3 * Vec::size);
+		store_aligned<Vec>(c_dst, v0);
+		store_aligned<Vec>(c_dst + Vec::size, v1);
+		store_aligned<Vec>(c_dst + 2 * Vec::size, v2);
+		store_aligned<Vec>(c_dst + 3 * Vec::size, v3);
+		c_dst += 4 * Vec::size;
+		c_src += 4 * Vec::size;
+	}
+	for (; cnt > Vec::size; cnt -= Vec::size) {
+		store_aligned<Vec>(c_dst, load<Vec>(c_src));
+		c_dst += Vec::size;
+		c_src += Vec::size;
+	}
+
+	store<Vec>(dst, head);
+	store<Vec>(last, tail);
+	return dst;
+}
+
+template<typename Vec>
+__FORCE_INLINE void *memset(void *dst, int val, size_t cnt)
+{
+	auto *c_dst = static_cast<unsigned char *>(dst);
+	const unsigned char byte = val;
+
+	if (cnt < Vec::size) {
+		while (cnt--)
+			*c_dst++ = byte;
+		return dst;
+	}
+
+	const typename Vec::Bytes bytes = typename Vec::Bytes{} + static_cast<char>(byte);
+
+	store<Vec>(dst, bytes);
+	store<Vec>(c_dst + cnt - Vec::size, bytes);
+
+	unsigned char *const end = c_dst + cnt - Vec::size;
+	c_dst = reinterpret_cast<unsigned char *>(
+			(reinterpret_cast<uintptr_t>(c_dst) + Vec::size) & ~(Vec::size - 1));
+
+	for (; c_dst + 4 * Vec::size <= end; c_dst += 4 * Vec::size) {
+		store_aligned<Vec>(c_dst, bytes);
+		store_aligned<Vec>(c_dst + Vec::size, bytes);
+		store_aligned<Vec>(c_dst + 2 * Vec::size, bytes);
+		store_aligned<Vec>(c_dst + 3 * Vec::size, bytes);
+	}
+	for (; c_dst < end; c_dst += Vec::size)
+		store_aligned<Vec>(c_dst, bytes);
+	return dst;
+}
+
+template<typename Vec>
+__FORCE_INLINE int memcmp(const void *s1, const void *s2, size_t cnt)
+{
+	const auto *c_s1 = static_cast<const unsigned char *>(s1);
+	const auto *c_s2 = static_cast<const unsigned char *>(s2);
+
+	for (; cnt >= Vec::size; cnt -= Vec::size) {
+		const unsigned int equal = equal_mask<Vec>(load<Vec>(c_s1), load<Vec>(c_s2));
+		if (equal != full_mask<Vec>) {
+			const unsigned int i = __builtin_ctz(~equal);
+			return c_s1[i] - c_s2[i];
+		}
+		c_s1 += Vec::size;
+		c_s2 += Vec::size;
+	}
+
+	for (; cnt; --cnt, ++c_s1, ++c_s2) {
+		if (*c_s1 != *c_s2)
+			return *c_s1 - *c_s2;
+	}
+	return 0;
+}
+
+/* Whether a vector read at ptr would cross into the next page, which may
+ * not be mapped. */
+template<typename Vec>
+__FORCE_INLINE bool crosses_page(const void *ptr)
+{
+	constexpr uintptr_t page_size = 4096;
+	return (reinterpret_cast<uintptr_t>(ptr) & (page_size - 1)) > page_size - Vec::size;
+}
+
+/* Mask of the bytes of the vector at the aligned address block that are
+ * either ch or zero. */
+template<typename Vec>
+__FORCE_INLINE unsigned int char_or_zero_mask(const char *block, char ch)
+{
+	const auto bytes = load_aligned<Vec>(block);
+	return equal_mask<Vec>(bytes, typename Vec::Bytes{} + ch)
+		| equal_mask<Vec>(bytes, typename Vec::Bytes{});
+}
+
+/* Mask of the bytes that differ between s1 and s2 or end s1. */
+template<typename Vec>
+__FORCE_INLINE unsigned int stop_mask(const char *s1, const char *s2)
+{
+	const auto bytes1 = load<Vec>(s1);
+	return (~equal_mask<Vec>(bytes1, load<Vec>(s2)) & full_mask<Vec>)
+		| equal_mask<Vec>(bytes1, typename Vec::Bytes{});
+}
+
+inline int char_diff(char c1, char c2)
+{
+	return static_cast<unsigned char>(c1) - static_cast<unsigned char>(c2);
+}
+
+template<typename Vec>
+__FORCE_INLINE size_t strlen(const char *str)
+{
+	// aligned loads never cross into the next page, so reading past the
+	// terminator can't fault
+	const auto offset = reinterpret_cast<uintptr_t>(str) & (Vec::size - 1);
+	const char *block = str - offset;
+	const typename Vec::Bytes zero = {};
+
+	unsigned int zeros = equal_mask<Vec>(load_aligned<Vec>(block), zero) >> offset;
+	if (zeros)
+		return __builtin_ctz(zeros);
+
+	for (;;) {
+		block += Vec::size;
+		zeros = equal_mask<Vec>(load_aligned<Vec>(block), zero);
+		if (zeros)
+			return block - str + __builtin_ctz(zeros);
+	}
+}
+
+template<typename Vec>
+__FORCE_INLINE size_t strnlen(const char *str, size_t n)
+{
+	if (!n)
+		return 0;
+
+	const auto offset = reinterpret_cast<uintptr_t>(str) & (Vec::size - 1);
+	const char *block = str - offset;
+	const typename Vec::Bytes zero = {};
+
+	size_t len;
+	unsigned int zeros = equal_mask<Vec>(load_aligned<Vec>(block), zero) >> offset;
+	if (zeros) {
+		len = __builtin_ctz(zeros);
+	} else {
+		for (;;) {
+			block += Vec::size;
+			if (size_t(block - str) >= n)
+				return n;
+			zeros = equal_mask<Vec>(load_aligned<Vec>(block), zero);
+			if (zeros) {
+				len = block - str + __builtin_ctz(zeros);
+				break;
+			}
+		}
+	}
+	return len < n ? len : n;
+}
+
+template<typename Vec>
+__FORCE_INLINE void *memchr(const void *ptr, int val, size_t cnt)
+{
+	if (!cnt)
+		return nullptr;
+
+	const auto *start = static_cast<const unsigned char *>(ptr);
+	const auto offset = reinterpret_cast<uintptr_t>(start) & (Vec::size - 1);
+	const unsigned char *block = start - offset;
+	const typename Vec::Bytes pattern = typename Vec::Bytes{} + static_cast<char>(val);
+
+	size_t pos;
+	unsigned int found = equal_mask<Vec>(load_aligned<Vec>(block), pattern) >> offset;
+	if (found) {
+		pos = __builtin_ctz(found);
+	} else {
+		for (;;) {
+			block += Vec::size;
+			if (size_t(block - start) >= cnt)
+				return nullptr;
+			found = equal_mask<Vec>(load_aligned<Vec>(block), pattern);
+			if (found) {
+				pos = block - start + __builtin_ctz(found);
+				break;
+			}
+		}
+	}
+	return pos < cnt ? const_cast<unsigned char *>(start + pos) : nullptr;
+}
+
+template<typename Vec>
+__FORCE_INLINE char *strchr(const char *str, int val)
+{
+	const char ch = val;
+	const auto offset = reinterpret_cast<uintptr_t>(str) & (Vec::size - 1);
+	const char *block = str - offset;
+
+	const char *pos;
+	unsigned int found = char_or_zero_mask<Vec>(block, ch) >> offset;
+	if (found) {
+		pos = str + __builtin_ctz(found);
+	} else {
+		for (;;) {
+			block += Vec::size;
+			found = char_or_zero_mask<Vec>(block, ch);
+			if (found) {
+				pos = block + __builtin_ctz(found);
+				break;
+			}
+		}
+	}
+	return *pos == ch ? const_cast<char *>(pos) : nullptr;
+}
+
+/* The strings can't both be read aligned, unaligned vectors are read
+ * instead and the bytes close to a page end are compared one by one. */
+template<typename Vec>
+__FORCE_INLINE int strcmp(const char *s1, const char *s2)
+{
+	for (;;) {
+		if (crosses_page<Vec>(s1) || crosses_page<Vec>(s2)) {
+			if (!*s1 || *s1 != *s2)
+				return char_diff(*s1, *s2);
+			++s1;
+			++s2;
+			continue;
+		}
+
+		const unsigned int stop = stop_mask<Vec>(s1, s2);
+		if (stop) {
+			const unsigned int i = __builtin_ctz(stop);
+			return char_diff(s1[i], s2[i]);
+		}
+		s1 += Vec::size;
+		s2 += Vec::size;
+	}
+}
+
+template<typename Vec>
+__FORCE_INLINE int strncmp(const char *s1, const char *s2, size_t n)
+{
+	while (n) {
+		if (n < Vec::size || crosses_page<Vec>(s1) || crosses_page<Vec>(s2)) {
+			if (!*s1 || *s1 != *s2)
+				return char_diff(*s1, *s2);
+			++s1;
+			++s2;
+			--n;
+			continue;
+		}
+
+		const unsigned int stop = stop_mask<Vec>(s1, s2);
+		if (stop) {
+			const unsigned int i = __builtin_ctz(stop);
+			return char_diff(s1[i], s2[i]);
+		}
+		s1 += Vec::size;
+		s2 += Vec::size;
+		n -= Vec::size;
+	}
+	return 0;
+}
+
+}
+
+#endif